@@ -35,25 +35,31 @@ std::vector<float> AudioProcessor::readAudio(const std::string &filePath) {
 }
 
 std::vector<float> AudioProcessor::preprocess(const std::vector<float> &audio) {
+  return preprocessChunk(audio.data(), audio.size(), true, true);
+}
+
+std::vector<float> AudioProcessor::preprocessChunk(const float *audio,
+                                                   size_t size, bool isFirst,
+                                                   bool isLast) {
+  const size_t padBegin = isFirst ? config_.padding30Frames : 0;
+  const size_t padEnd = isLast ? config_.padding31Frames : 0;
+
   std::vector<float> paddedAudio;
-  paddedAudio.resize(config_.padding30Frames + audio.size() +
-                     config_.padding31Frames);
+  paddedAudio.resize(padBegin + size + padEnd);
 
   // Fill beginning with zeros
-  std::fill(paddedAudio.begin(), paddedAudio.begin() + config_.padding30Frames,
-            0.0f);
+  std::fill(paddedAudio.begin(), paddedAudio.begin() + padBegin, 0.0f);
 
   // Convert and copy audio data
-  std::transform(
-      audio.begin(), audio.end(), paddedAudio.begin() + config_.padding30Frames,
-      [this](float x) {
-        int16_t scaled = static_cast<int16_t>(x * config_.amplitudeScale);
-        return static_cast<float>(scaled);
-      });
+  std::transform(audio, audio + size, paddedAudio.begin() + padBegin,
+                 [this](float x) {
+                   int16_t scaled =
+                       static_cast<int16_t>(x * config_.amplitudeScale);
+                   return static_cast<float>(scaled);
+                 });
 
   // Fill end with zeros
-  std::fill(paddedAudio.begin() + config_.padding30Frames + audio.size(),
-            paddedAudio.end(), 0.0f);
+  std::fill(paddedAudio.begin() + padBegin + size, paddedAudio.end(), 0.0f);
 
   return paddedAudio;
 }
@@ -32,6 +32,14 @@ public:
   std::vector<float> readAudio(const std::string &filePath);
   std::vector<float> preprocess(const std::vector<float> &audio);
 
+  /**
+   * @brief Preprocess one piece of a streamed waveform. Concatenating the
+   * results of consecutive calls (first call with isFirst, last call with
+   * isLast) yields exactly preprocess() of the whole waveform.
+   */
+  std::vector<float> preprocessChunk(const float *audio, size_t size,
+                                     bool isFirst, bool isLast);
+
 private:
   AudioConfig config_;
 };
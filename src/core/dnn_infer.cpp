@@ -11,36 +11,19 @@
 
 #include "dnn_infer.hpp"
 #include "logger/logger.hpp"
+#include "model_registry.hpp"
+#include <algorithm>
+#include <stdexcept>
 
 namespace lip_sync::infer::dnn {
 bool AlgoInference::initialize() {
   try {
-    // create environment
-    env = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING,
-                                     mParams.name.c_str());
-
-    // session options
-    Ort::SessionOptions sessionOptions;
-    sessionOptions.SetIntraOpNumThreads(1);
-    sessionOptions.SetGraphOptimizationLevel(
-        GraphOptimizationLevel::ORT_ENABLE_ALL);
-
-    // create session
-#ifdef _WIN32
-    // Windows: Convert string to wstring for UTF-16 support
-    size_t size = mParams.modelPath.length();
-    session = std::make_unique<Ort::Session>(
-        *env, 
-        mParams.modelPath.c_str(),
-        size,  // Pass the size of the model path string
-        sessionOptions);
-#else
-    // Non-Windows platforms can use the original code
-    session = std::make_unique<Ort::Session>(
-        *env, 
-        mParams.modelPath.c_str(),
-        sessionOptions);
-#endif
+    // the session is shared by every inference object of the model
+    session = ModelRegistry::instance().acquire(
+        mParams.modelPath, mParams.session, mParams.replica);
+    if (!session) {
+      return false;
+    }
 
     // create memory info
     memoryInfo = std::make_unique<Ort::MemoryInfo>(
@@ -79,6 +62,19 @@ bool AlgoInference::initialize() {
       outputShapes[i] = tensorInfo.GetShape();
     }
 
+    inputNamesPtr.clear();
+    outputNamesPtr.clear();
+    for (const auto &name : inputNames) {
+      inputNamesPtr.push_back(name.c_str());
+    }
+    for (const auto &name : outputNames) {
+      outputNamesPtr.push_back(name.c_str());
+    }
+
+    binding = std::make_unique<Ort::IoBinding>(*session);
+    boundInputs.resize(numInputNodes);
+    boundOutputs.resize(numOutputNodes);
+
     return true;
   } catch (const Ort::Exception &e) {
     LOGGER_ERROR("ONNX Runtime error during initialization: {}", e.what());
@@ -91,22 +87,110 @@ bool AlgoInference::initialize() {
 
 void AlgoInference::terminate() {
   try {
-    inputTensors.clear();
-    outputTensors.clear();
+    binding.reset();
+    boundInputs.clear();
+    boundOutputs.clear();
+    outputShapeCache.clear();
 
     session.reset();
-    env.reset();
     memoryInfo.reset();
 
     inputNames.clear();
     inputShape.clear();
     outputNames.clear();
     outputShapes.clear();
+    inputNamesPtr.clear();
+    outputNamesPtr.clear();
   } catch (const std::exception &e) {
     LOGGER_ERROR("Error during termination: {}", e.what());
   }
 }
 
+template <typename T>
+void AlgoInference::bindTensor(BoundTensor &bound, const char *name,
+                               bool output, T *data, size_t count,
+                               const int64_t *shape, size_t rank) {
+  if (bound.data == data && bound.shape.size() == rank &&
+      std::equal(shape, shape + rank, bound.shape.begin())) {
+    return;
+  }
+  bound.value =
+      Ort::Value::CreateTensor<T>(*memoryInfo, data, count, shape, rank);
+  bound.data = data;
+  bound.shape.assign(shape, shape + rank);
+  if (output) {
+    binding->BindOutput(name, bound.value);
+  } else {
+    binding->BindInput(name, bound.value);
+  }
+}
+
+void AlgoInference::bindInput(size_t index, const float *data, size_t count,
+                              const int64_t *shape, size_t rank) {
+  // Inputs are only read, the tensor API takes them mutable
+  bindTensor(boundInputs.at(index), inputNamesPtr[index], false,
+             const_cast<float *>(data), count, shape, rank);
+}
+
+void AlgoInference::bindInput(size_t index, const int64_t *data,
+                              size_t count, const int64_t *shape,
+                              size_t rank) {
+  bindTensor(boundInputs.at(index), inputNamesPtr[index], false,
+             const_cast<int64_t *>(data), count, shape, rank);
+}
+
+void AlgoInference::runBinding(
+    std::initializer_list<std::vector<float> *> outputs) {
+  if (outputs.size() != outputNamesPtr.size()) {
+    throw std::invalid_argument("Expected one buffer per model output");
+  }
+
+  shapeKey.clear();
+  for (const auto &bound : boundInputs) {
+    shapeKey.push_back(bound.shape.size());
+    shapeKey.insert(shapeKey.end(), bound.shape.begin(), bound.shape.end());
+  }
+
+  auto iter = outputShapeCache.find(shapeKey);
+  if (iter != outputShapeCache.end()) {
+    size_t i = 0;
+    for (auto *buffer : outputs) {
+      const auto &shape = iter->second[i];
+      size_t count = 1;
+      for (int64_t dim : shape) {
+        count *= dim;
+      }
+      buffer->resize(count);
+      bindTensor(boundOutputs[i], outputNamesPtr[i], true, buffer->data(),
+                 count, shape.data(), shape.size());
+      ++i;
+    }
+    session->Run(Ort::RunOptions{nullptr}, *binding);
+    return;
+  }
+
+  // First run with these input shapes, ORT allocates the outputs and their
+  // shapes are kept for the next runs
+  for (size_t i = 0; i < outputNamesPtr.size(); ++i) {
+    binding->BindOutput(outputNamesPtr[i], *memoryInfo);
+    boundOutputs[i] = BoundTensor{};
+  }
+  session->Run(Ort::RunOptions{nullptr}, *binding);
+
+  auto values = binding->GetOutputValues();
+  std::vector<std::vector<int64_t>> shapes;
+  size_t i = 0;
+  for (auto *buffer : outputs) {
+    auto tensorInfo = values[i].GetTensorTypeAndShapeInfo();
+    const float *data = values[i].GetTensorData<float>();
+    buffer->assign(data, data + tensorInfo.GetElementCount());
+    shapes.push_back(tensorInfo.GetShape());
+    ++i;
+  }
+  LOGGER_DEBUG("{} output shapes learnt for new input shapes", mParams.name);
+  outputShapeCache.emplace(shapeKey, std::move(shapes));
+}
+
 std::shared_ptr<ModelInfo> AlgoInference::getModelInfo() {
   if (modelInfo)
     return modelInfo;
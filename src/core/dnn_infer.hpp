@@ -13,6 +13,8 @@
 #define __ONNXRUNTIME_INFERENCE_H_
 
 #include "types.hpp"
+#include <initializer_list>
+#include <map>
 #include <memory>
 #include <onnxruntime_cxx_api.h>
 
@@ -58,23 +60,66 @@ public:
   virtual void terminate();
 
 protected:
+  /**
+   * @brief Bind a caller owned buffer to an input of the IoBinding path. The
+   * buffer is read in place and has to stay valid until runBinding()
+   * returns. Binding the same buffer with the same shape again is a no-op.
+   */
+  void bindInput(size_t index, const float *data, size_t count,
+                 const int64_t *shape, size_t rank);
+  void bindInput(size_t index, const int64_t *data, size_t count,
+                 const int64_t *shape, size_t rank);
+
+  /**
+   * @brief Run the session on the bound inputs, writing output i into
+   * outputs[i], which is resized to the output size. The outputs are bound
+   * in place once their shapes are known. Those are learnt from a run with
+   * tensors allocated by ORT for each new combination of input shapes, so
+   * that dynamic output dimensions need no knowledge of the model. A caller
+   * that keeps its buffers allocates and copies nothing in the steady
+   * state.
+   */
+  void runBinding(std::initializer_list<std::vector<float> *> outputs);
+
   AlgoBase mParams;
 
   std::shared_ptr<ModelInfo> modelInfo;
 
-  std::vector<Ort::Value> inputTensors;
-  std::vector<Ort::Value> outputTensors;
-
   std::vector<std::string> inputNames;
   std::vector<std::vector<int64_t>> inputShape;
 
   std::vector<std::string> outputNames;
   std::vector<std::vector<int64_t>> outputShapes;
 
-  // infer engine
-  std::unique_ptr<Ort::Env> env;
-  std::unique_ptr<Ort::Session> session;
+  // Name arrays as given to the session, pointing into the names above
+  std::vector<const char *> inputNamesPtr;
+  std::vector<const char *> outputNamesPtr;
+
+  // infer engine, the session is shared through the model registry
+  std::shared_ptr<Ort::Session> session;
   std::unique_ptr<Ort::MemoryInfo> memoryInfo;
+
+private:
+  // A tensor bound to the binding and the buffer and shape it views
+  struct BoundTensor {
+    const void *data = nullptr;
+    std::vector<int64_t> shape;
+    Ort::Value value{nullptr};
+  };
+
+  template <typename T>
+  void bindTensor(BoundTensor &bound, const char *name, bool output, T *data,
+                  size_t count, const int64_t *shape, size_t rank);
+
+  std::unique_ptr<Ort::IoBinding> binding;
+  std::vector<BoundTensor> boundInputs;
+  std::vector<BoundTensor> boundOutputs;
+
+  // Output shapes learnt per combination of input shapes, keyed by the
+  // rank and dimensions of every input in turn
+  std::vector<int64_t> shapeKey;
+  std::map<std::vector<int64_t>, std::vector<std::vector<int64_t>>>
+      outputShapeCache;
 };
 } // namespace lip_sync::infer::dnn
 #endif
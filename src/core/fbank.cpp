@@ -1,6 +1,10 @@
 #include "fbank.hpp"
+#include "fbank_kernels.hpp"
+#include "utils/thread_pool.hpp"
 #include <algorithm>
 #include <cstring>
+#include <exception>
+#include <future>
 #include <kiss_fft.h>
 #include <kiss_fftr.h>
 #include <stdexcept>
@@ -37,20 +41,43 @@ FbankComputer::FbankComputer(const FbankOptions &opts)
     throw std::runtime_error("Padded window size must be even");
   }
 
-  // Initialize FFT
-  kiss_fftr_cfg cfg =
-      kiss_fftr_alloc(padded_window_size_, false, nullptr, nullptr);
-  if (!cfg) {
-    throw std::runtime_error("Failed to allocate FFT config");
-  }
-  fft_config_.reset(cfg);
-  if (!fft_config_) {
-    throw std::runtime_error("Failed to allocate FFT config");
-  }
+  // Specialized transform for the common power-of-two sizes, kiss_fftr
+  // serves the others
+  InitWorkspace(workspace_);
+
+  if (UsesDefaultTables()) {
+    // Window and sparse mel banks baked at compile time
+    using tables::kMelTable;
+    window_.assign(tables::kPoveyWindow.begin(), tables::kPoveyWindow.end());
+    for (int i = 0; i < opts_.num_mel_bins; i++) {
+      mel_ranges_.push_back(MelRange{kMelTable.first_bin[i],
+                                     kMelTable.num_bins[i],
+                                     kMelTable.offset[i]});
+    }
+    mel_weights_.assign(kMelTable.weights.begin(), kMelTable.weights.end());
+  } else {
+    // Initialize mel banks
+    auto mel_banks_pair = GetMelBanks();
+    mel_banks_ = std::move(mel_banks_pair.first);
+
+    // Keep only the nonzero span of each triangle for the fast path
+    for (const auto &bank : mel_banks_) {
+      int first = 0;
+      int last = static_cast<int>(bank.size()) - 1;
+      while (first <= last && bank[first] == 0.0f) {
+        first++;
+      }
+      while (last >= first && bank[last] == 0.0f) {
+        last--;
+      }
+      mel_ranges_.push_back(MelRange{first, last - first + 1,
+                                     static_cast<int>(mel_weights_.size())});
+      mel_weights_.insert(mel_weights_.end(), bank.begin() + first,
+                          bank.begin() + last + 1);
+    }
 
-  // Initialize mel banks
-  auto mel_banks_pair = GetMelBanks();
-  mel_banks_ = std::move(mel_banks_pair.first);
+    window_ = GetWindowFunction(frame_length_samples_);
+  }
 }
 
 FbankComputer::~FbankComputer() = default;
@@ -134,6 +161,345 @@ void FbankComputer::PreprocessFrame(std::vector<float> &frame,
 
 std::vector<std::vector<float>>
 FbankComputer::Compute(const std::vector<float> &waveform) {
+  std::vector<float> flat;
+  const int num_frames = Compute(waveform.data(), waveform.size(), flat);
+
+  const int dim = Dim();
+  std::vector<std::vector<float>> features;
+  features.reserve(num_frames);
+  for (int i = 0; i < num_frames; i++) {
+    features.emplace_back(flat.begin() + i * dim,
+                          flat.begin() + (i + 1) * dim);
+  }
+  return features;
+}
+
+int FbankComputer::Compute(const float *waveform, size_t num_samples,
+                           std::vector<float> &features) {
+  const int num_frames = NumFrames(static_cast<int>(num_samples));
+  const int dim = Dim();
+  const size_t first_row = features.size();
+  features.resize(first_row + static_cast<size_t>(num_frames) * dim);
+  ComputeFrames(workspace_, waveform, 0, num_samples, 0, num_frames,
+                features.data() + first_row, false);
+
+  if (opts_.subtract_mean) {
+    SubtractMean(features.data() + first_row, num_frames);
+  }
+  return num_frames;
+}
+
+int FbankComputer::NumFrames(int64_t num_samples) const {
+  if (num_samples == 0) {
+    return 0;
+  }
+  if (opts_.snip_edges) {
+    if (num_samples < frame_length_samples_) {
+      return 0;
+    }
+    return static_cast<int>(
+        1 + (num_samples - frame_length_samples_) / frame_shift_samples_);
+  }
+  return static_cast<int>((num_samples + frame_shift_samples_ / 2) /
+                          frame_shift_samples_);
+}
+
+void FbankComputer::ExtractFrame(const float *samples, int64_t first_sample,
+                                 int64_t num_samples, int index,
+                                 float *frame) const {
+  const int64_t start_sample =
+      static_cast<int64_t>(index) * frame_shift_samples_;
+
+  if (opts_.snip_edges) {
+    std::memcpy(frame, samples + (start_sample - first_sample),
+                frame_length_samples_ * sizeof(float));
+  } else {
+    // Handle edge effects by reflection
+    for (int j = 0; j < frame_length_samples_; j++) {
+      int64_t sample_index = start_sample + j - frame_length_samples_ / 2;
+      if (sample_index < 0) {
+        sample_index = -sample_index - 1;
+      } else if (sample_index >= num_samples) {
+        sample_index = 2 * num_samples - sample_index - 1;
+      }
+      frame[j] = samples[sample_index - first_sample];
+    }
+  }
+
+  // The FFT input is zero padded past the frame
+  std::fill(frame + frame_length_samples_, frame + padded_window_size_, 0.0f);
+}
+
+void FbankComputer::AcceptWaveform(Stream &stream, const float *samples,
+                                   size_t num_samples) {
+  if (opts_.subtract_mean) {
+    throw std::runtime_error("subtract_mean is not supported when streaming");
+  }
+  if (stream.finished) {
+    throw std::runtime_error("Waveform accepted after InputFinished");
+  }
+  stream.samples.insert(stream.samples.end(), samples, samples + num_samples);
+  stream.num_samples += num_samples;
+}
+
+void FbankComputer::InputFinished(Stream &stream) { stream.finished = true; }
+
+int FbankComputer::PopFrames(Stream &stream, std::vector<float> &features) {
+  // Until the end is known, only frames lying completely inside the samples
+  // received so far are computed
+  int num_frames = NumFrames(stream.num_samples);
+  if (!stream.finished) {
+    const int reach = opts_.snip_edges
+                          ? frame_length_samples_
+                          : frame_length_samples_ - frame_length_samples_ / 2;
+    const int complete =
+        stream.num_samples < reach
+            ? 0
+            : static_cast<int>(1 + (stream.num_samples - reach) /
+                                       frame_shift_samples_);
+    num_frames = std::min(num_frames, complete);
+  }
+
+  const int dim = Dim();
+  const size_t first_row = features.size();
+  const int num_popped = std::max(num_frames - stream.num_frames, 0);
+  features.resize(first_row + static_cast<size_t>(num_popped) * dim);
+  ComputeFrames(workspace_, stream.samples.data(), stream.offset,
+                stream.num_samples, stream.num_frames, num_popped,
+                features.data() + first_row, false);
+  stream.num_frames += num_popped;
+
+  // Keep the samples from the start of the next frame on
+  int64_t keep_from =
+      static_cast<int64_t>(stream.num_frames) * frame_shift_samples_;
+  if (!opts_.snip_edges) {
+    keep_from -= frame_length_samples_ / 2;
+  }
+  const int64_t drop = std::min<int64_t>(
+      std::max<int64_t>(keep_from - stream.offset, 0), stream.samples.size());
+  stream.samples.erase(stream.samples.begin(), stream.samples.begin() + drop);
+  stream.offset += drop;
+
+  return num_popped;
+}
+
+int FbankComputer::Compute(const float *waveform, size_t num_samples,
+                           std::vector<float> &features,
+                           utils::thread_pool &pool) {
+  const int num_frames = NumFrames(static_cast<int64_t>(num_samples));
+  const int dim = Dim();
+  const size_t first_row = features.size();
+  features.resize(first_row + static_cast<size_t>(num_frames) * dim);
+  float *out = features.data() + first_row;
+
+  // Fixed size tasks write disjoint rows, so neither the output nor the
+  // dither noise depends on the number of threads
+  std::vector<std::future<void>> tasks;
+  for (int first = 0; first < num_frames; first += kParallelFrames) {
+    const int count = std::min(kParallelFrames, num_frames - first);
+    tasks.push_back(pool.submit([this, waveform, num_samples, first, count,
+                                 out, dim]() {
+      Workspace workspace;
+      InitWorkspace(workspace);
+      ComputeFrames(workspace, waveform, 0, num_samples, first, count,
+                    out + static_cast<size_t>(first) * dim, true);
+    }));
+  }
+  // Wait for every task before rethrowing, they write into features
+  std::exception_ptr error;
+  for (auto &task : tasks) {
+    try {
+      task.get();
+    } catch (...) {
+      error = error ? error : std::current_exception();
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  if (opts_.subtract_mean) {
+    SubtractMean(out, num_frames);
+  }
+  return num_frames;
+}
+
+void FbankComputer::InitWorkspace(Workspace &workspace) const {
+  // Specialized transform for the common power-of-two sizes, kiss_fftr
+  // serves the others
+  workspace.fft = fft::CreateRealFft(padded_window_size_);
+  if (!workspace.fft) {
+    InitKissFft(workspace);
+  }
+  workspace.frame_buf.assign(kFrameBlock * padded_window_size_, 0.0f);
+  workspace.fft_buf.resize(kFrameBlock * (padded_window_size_ + 2));
+  workspace.power_buf.resize(padded_window_size_ / 2 + 1);
+  workspace.energy_buf.resize(kFrameBlock);
+}
+
+uint32_t FbankComputer::FrameSeed(int index) const {
+  // splitmix64 of the seed and the frame index
+  uint64_t z = (static_cast<uint64_t>(opts_.dither_seed) << 32) +
+               static_cast<uint32_t>(index) + 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return static_cast<uint32_t>(z ^ (z >> 31));
+}
+
+void FbankComputer::ComputeFrames(Workspace &ws, const float *samples,
+                                  int64_t first_sample, int64_t num_samples,
+                                  int first_frame, int num_frames, float *out,
+                                  bool seed_frames) {
+  // Frames are prepared, transformed and finished in blocks, one transform
+  // per frame
+  const int dim = Dim();
+  const int spectrum_stride = padded_window_size_ + 2;
+  for (int block = 0; block < num_frames; block += kFrameBlock) {
+    const int count = std::min(kFrameBlock, num_frames - block);
+    for (int i = 0; i < count; i++) {
+      const int index = first_frame + block + i;
+      float *frame = ws.frame_buf.data() + i * padded_window_size_;
+      ExtractFrame(samples, first_sample, num_samples, index, frame);
+      if (seed_frames) {
+        ws.rng.seed(FrameSeed(index));
+        ws.normal_dist.reset();
+        ws.energy_buf[i] = PrepareFrame(frame, ws.rng, ws.normal_dist);
+      } else {
+        ws.energy_buf[i] = PrepareFrame(frame, rng_, normal_dist_);
+      }
+    }
+
+    for (int i = 0; i < count; i++) {
+      const float *frame = ws.frame_buf.data() + i * padded_window_size_;
+      float *spectrum = ws.fft_buf.data() + i * spectrum_stride;
+      if (ws.fft) {
+        ws.fft->Forward(frame, spectrum);
+      } else {
+        kiss_fftr(ws.kiss.get(), frame,
+                  reinterpret_cast<kiss_fft_cpx *>(spectrum));
+      }
+    }
+
+    for (int i = 0; i < count; i++) {
+      FinishFrame(ws, ws.fft_buf.data() + i * spectrum_stride,
+                  ws.energy_buf[i], out + static_cast<size_t>(block + i) * dim);
+    }
+  }
+}
+
+float FbankComputer::PrepareFrame(float *frame, std::mt19937 &rng,
+                                  std::normal_distribution<float> &dist) const {
+  const int length = frame_length_samples_;
+
+  auto log_energy = [&]() {
+    float energy = std::max(kernels::Dot(frame, frame, length), kEpsilon);
+    if (opts_.energy_floor > 0.0f) {
+      energy = std::max(energy, opts_.energy_floor);
+    }
+    return std::log(energy);
+  };
+
+  float energy = 0.0f;
+  if (opts_.use_energy && opts_.raw_energy) {
+    energy = log_energy();
+  }
+
+  if (opts_.dither != 0.0f) {
+    for (int i = 0; i < length; i++) {
+      frame[i] += opts_.dither * dist(rng);
+    }
+  }
+
+  if (opts_.remove_dc_offset) {
+    kernels::AddScalar(frame, length, -kernels::Sum(frame, length) / length);
+  }
+
+  if (opts_.preemphasis_coefficient != 0.0f) {
+    kernels::Preemphasis(frame, length, opts_.preemphasis_coefficient);
+  }
+
+  if (opts_.use_energy && !opts_.raw_energy) {
+    energy = log_energy();
+  }
+
+  kernels::Multiply(frame, window_.data(), length);
+  return energy;
+}
+
+void FbankComputer::FinishFrame(Workspace &ws, const float *spectrum,
+                                float energy, float *out) const {
+  float *power = ws.power_buf.data();
+  const int num_bins = static_cast<int>(ws.power_buf.size());
+  kernels::PowerSpectrum(spectrum, power, num_bins,
+                         opts_.use_power, kEpsilon);
+
+  // Energy goes first, or last with htk_compat
+  float *mel = out + (opts_.use_energy && !opts_.htk_compat ? 1 : 0);
+  for (int i = 0; i < opts_.num_mel_bins; i++) {
+    const auto &range = mel_ranges_[i];
+    mel[i] = kernels::Dot(mel_weights_.data() + range.offset,
+                          power + range.first_bin, range.num_bins);
+  }
+  if (opts_.use_log_fbank) {
+    kernels::LogFloor(mel, opts_.num_mel_bins, kEpsilon);
+  }
+
+  if (opts_.use_energy) {
+    out[opts_.htk_compat ? opts_.num_mel_bins : 0] = energy;
+  }
+}
+
+void FbankComputer::SubtractMean(float *features, int num_frames) const {
+  if (num_frames == 0) {
+    return;
+  }
+  const int dim = Dim();
+  std::vector<float> means(dim, 0.0f);
+  for (int i = 0; i < num_frames; i++) {
+    for (int j = 0; j < dim; j++) {
+      means[j] += features[i * dim + j];
+    }
+  }
+  for (int j = 0; j < dim; j++) {
+    means[j] = -means[j] / num_frames;
+  }
+  for (int i = 0; i < num_frames; i++) {
+    for (int j = 0; j < dim; j++) {
+      features[i * dim + j] += means[j];
+    }
+  }
+}
+
+bool FbankComputer::UsesDefaultTables() const {
+  using tables::DefaultFbank;
+  return opts_.num_mel_bins == DefaultFbank::kNumMelBins &&
+         opts_.sample_frequency == DefaultFbank::kSampleFrequency &&
+         frame_length_samples_ == DefaultFbank::kFrameLength &&
+         padded_window_size_ == DefaultFbank::kPaddedSize &&
+         opts_.window_type == "povey" &&
+         opts_.low_freq == DefaultFbank::kLowFreq && opts_.high_freq == 0.0f &&
+         opts_.vtln_warp == 1.0f;
+}
+
+void FbankComputer::InitKissFft(Workspace &workspace) const {
+  kiss_fftr_cfg cfg =
+      kiss_fftr_alloc(padded_window_size_, false, nullptr, nullptr);
+  if (!cfg) {
+    throw std::runtime_error("Failed to allocate FFT config");
+  }
+  workspace.kiss.reset(cfg);
+}
+
+std::vector<std::vector<float>>
+FbankComputer::ComputeReference(const std::vector<float> &waveform) {
+  // The fast path may get by without these
+  if (!workspace_.kiss) {
+    InitKissFft(workspace_);
+  }
+  if (mel_banks_.empty()) {
+    mel_banks_ = GetMelBanks().first;
+  }
+
   auto frames = GetStridedFrames(waveform);
   std::vector<std::vector<float>> features;
   features.reserve(frames.size());
@@ -157,7 +523,7 @@ FbankComputer::Compute(const std::vector<float> &waveform) {
               0.0f);
 
     // Perform FFT
-    kiss_fftr(fft_config_.get(), padded_frame.data(),
+    kiss_fftr(workspace_.kiss.get(), padded_frame.data(),
               reinterpret_cast<kiss_fft_cpx *>(fft_out.data()));
 
     // Compute power spectrum
@@ -1,12 +1,18 @@
 #ifndef __LIP_SYNC_FBANK_HPP_
 #define __LIP_SYNC_FBANK_HPP_
 
+#include "fbank_fft.hpp"
 #include "kiss_fftr.h"
 #include <cmath>
+#include <cstdint>
 #include <memory>
 #include <random>
 #include <vector>
 
+namespace utils {
+class thread_pool;
+}
+
 namespace lip_sync::infer {
 
 class FbankComputer {
@@ -15,6 +21,8 @@ public:
     float blackman_coeff = 0.42f;
     int channel = -1;
     float dither = 0.0f;
+    // Seed of the per frame dither noise of the parallel Compute
+    uint32_t dither_seed = 0;
     float energy_floor = 1.0f;
     float frame_length = 25.0f;
     float frame_shift = 10.0f;
@@ -44,9 +52,72 @@ public:
   // Main compute function
   std::vector<std::vector<float>> Compute(const std::vector<float> &waveform);
 
+  // Fast path: appends Dim() floats per frame to `features` as contiguous
+  // row-major rows and returns the number of frames appended. Uses sparse mel
+  // banks, vectorized kernels and reused scratch buffers, so an instance must
+  // not be used by several threads at once. Matches ComputeReference within
+  // 1e-4 absolute on log-mel outputs whose energy is at least 1e-4 of the
+  // frame's largest mel energy. Float rounding in the FFT and the vector
+  // kernels is relative to the whole frame, so weaker mel bins, e.g. the
+  // narrow low ones on noise, can differ by 1e-3 or more in the log domain;
+  // their linear energies still agree within 1e-4 of the frame's largest.
+  int Compute(const float *waveform, size_t num_samples,
+              std::vector<float> &features);
+
+  // Parallel fast path for long audio: the frames are split into fixed size
+  // ranges computed as tasks of `pool`, each with scratch buffers of its own,
+  // and written in frame order. Dither noise of every frame comes from a
+  // generator seeded with dither_seed and the frame index, so the output is
+  // reproducible and does not depend on the number of threads (it differs
+  // from the serial Compute, which draws from one random stream). Blocks
+  // until all tasks are done, so it must not be called from a task of the
+  // same pool.
+  int Compute(const float *waveform, size_t num_samples,
+              std::vector<float> &features, utils::thread_pool &pool);
+
+  // Straightforward per-frame implementation, kept as the reference the fast
+  // path is checked against
+  std::vector<std::vector<float>>
+  ComputeReference(const std::vector<float> &waveform);
+
+  // Carry-over state of one stream: the samples from offset on that later
+  // frames still need and the number of frames popped so far. It is kept
+  // outside the computer so that one instance can serve several streams.
+  struct Stream {
+    std::vector<float> samples;
+    int64_t offset = 0;
+    int64_t num_samples = 0;
+    int num_frames = 0;
+    bool finished = false;
+  };
+
+  // Streaming interface: feed samples in chunks of any size, then PopFrames
+  // appends the frames that became complete in the layout of the fast
+  // Compute and returns their number. The partial frame tail is kept in
+  // `stream` between calls, so the frames popped over a stream equal
+  // Compute() of the concatenated samples. Preemphasis and DC removal are
+  // per frame and need no further history. Without snip_edges the last
+  // frames reflect the end of the signal and are only popped after
+  // InputFinished(). subtract_mean needs the whole input and is not
+  // supported when streaming.
+  void AcceptWaveform(Stream &stream, const float *samples,
+                      size_t num_samples);
+  void InputFinished(Stream &stream);
+  int PopFrames(Stream &stream, std::vector<float> &features);
+
+  int FrameLengthSamples() const { return frame_length_samples_; }
+  int FrameShiftSamples() const { return frame_shift_samples_; }
+
+  // Number of values per output frame
+  int Dim() const { return opts_.num_mel_bins + (opts_.use_energy ? 1 : 0); }
+
 private:
   static constexpr float kEpsilon = 1.1920928955078125e-07f;
   static constexpr float kMsToSec = 0.001f;
+  // Frames prepared, transformed and finished per block of the fast path
+  static constexpr int kFrameBlock = 16;
+  // Frames per task of the parallel Compute
+  static constexpr int kParallelFrames = 512;
 
   struct KissFFTRDeleter {
     void operator()(kiss_fftr_cfg cfg) { kiss_fftr_free(cfg); }
@@ -78,13 +149,67 @@ private:
   std::pair<std::vector<std::vector<float>>, std::vector<float>>
   GetMelBanks() const;
 
+  // Scratch of one thread of the fast path: the transform, which has
+  // scratch of its own, frames and spectra of one block, and the
+  // generator of per frame seeded dither
+  struct Workspace {
+    std::unique_ptr<fft::RealFft> fft;
+    std::unique_ptr<kiss_fftr_state, KissFFTRDeleter> kiss;
+    std::vector<float> frame_buf;
+    std::vector<float> fft_buf;
+    std::vector<float> power_buf;
+    std::vector<float> energy_buf;
+    std::mt19937 rng;
+    std::normal_distribution<float> normal_dist{0.0f, 1.0f};
+  };
+
+  // Whether the options match the tables baked in fbank_tables.hpp
+  bool UsesDefaultTables() const;
+  void InitKissFft(Workspace &workspace) const;
+  void InitWorkspace(Workspace &workspace) const;
+  uint32_t FrameSeed(int index) const;
+
+  // Fast path helpers working on the scratch buffers
+  int NumFrames(int64_t num_samples) const;
+  // samples[k] holds sample first_sample + k of a signal of num_samples
+  void ExtractFrame(const float *samples, int64_t first_sample,
+                    int64_t num_samples, int index, float *frame) const;
+  // With seed_frames the dither of each frame is seeded from its index,
+  // otherwise it is drawn from the instance's generator
+  void ComputeFrames(Workspace &ws, const float *samples, int64_t first_sample,
+                     int64_t num_samples, int first_frame, int num_frames,
+                     float *out, bool seed_frames);
+  // Per frame steps before the FFT, returning the log energy, and after it
+  float PrepareFrame(float *frame, std::mt19937 &rng,
+                     std::normal_distribution<float> &dist) const;
+  void FinishFrame(Workspace &ws, const float *spectrum, float energy,
+                   float *out) const;
+  void SubtractMean(float *features, int num_frames) const;
+
   // Member variables
   FbankOptions opts_;
   int frame_length_samples_;
   int frame_shift_samples_;
   int padded_window_size_;
-  std::unique_ptr<kiss_fftr_state, KissFFTRDeleter> fft_config_;
+  // Dense mel banks of the reference path, left empty with baked tables
+  // until ComputeReference needs them
   std::vector<std::vector<float>> mel_banks_;
+
+  // Sparse mel banks: each filter's nonzero weights are num_bins consecutive
+  // values at offset in mel_weights_, applied from first_bin
+  struct MelRange {
+    int first_bin;
+    int num_bins;
+    int offset;
+  };
+  std::vector<MelRange> mel_ranges_;
+  std::vector<float> mel_weights_;
+  std::vector<float> window_;
+
+  // Scratch of the serial paths, its kiss_fftr config also serves
+  // ComputeReference
+  Workspace workspace_;
+
   std::mt19937 rng_; // Random number generator
   std::normal_distribution<float> normal_dist_;
 };
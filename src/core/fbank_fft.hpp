@@ -0,0 +1,185 @@
+/**
+ * @file fbank_fft.hpp
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Split-radix real FFT specialized for power-of-two fbank sizes
+ * @version 0.1
+ * @date 2025-01-04
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __LIP_SYNC_FBANK_FFT_HPP_
+#define __LIP_SYNC_FBANK_FFT_HPP_
+
+#include "fbank_tables.hpp"
+#include <array>
+#include <memory>
+
+namespace lip_sync::infer::fft {
+
+// Twiddles of one split-radix level of size M: W^k and W^3k for k < M / 4,
+// with W = exp(-2 pi i / M)
+template <int M> struct Twiddles {
+  std::array<float, M / 4> w1r{}, w1i{}, w3r{}, w3i{};
+
+  constexpr Twiddles() {
+    for (int k = 0; k < M / 4; k++) {
+      const double angle = -2.0 * tables::kPi * k / M;
+      w1r[k] = static_cast<float>(tables::Cos(angle));
+      w1i[k] = static_cast<float>(tables::Sin(angle));
+      w3r[k] = static_cast<float>(tables::Cos(3.0 * angle));
+      w3i[k] = static_cast<float>(tables::Sin(3.0 * angle));
+    }
+  }
+};
+
+// Separation twiddles of an N-point real transform, exp(-2 pi i k / N) for
+// k <= N / 2
+template <int N> struct RealTwiddles {
+  std::array<float, N / 2 + 1> r{}, i{};
+
+  constexpr RealTwiddles() {
+    for (int k = 0; k <= N / 2; k++) {
+      const double angle = -2.0 * tables::kPi * k / N;
+      r[k] = static_cast<float>(tables::Cos(angle));
+      i[k] = static_cast<float>(tables::Sin(angle));
+    }
+  }
+};
+
+// Baked into the binary, no table is computed at run time
+template <int M> inline constexpr Twiddles<M> kTwiddles{};
+template <int N> inline constexpr RealTwiddles<N> kRealTwiddles{};
+
+// Complex split-radix DIT transform of M points read with a stride, written
+// contiguously as separate real and imaginary arrays. The even half lands in
+// out[0, M/2), the 4n+1 and 4n+3 quarters after it, and the butterflies then
+// combine them in place. The recursion is resolved at compile time and the
+// butterfly loop runs over contiguous arrays, which compilers vectorize.
+template <int M> struct SplitRadix {
+  static void Run(const float *in_re, const float *in_im, int stride,
+                  float *out_re, float *out_im) {
+    constexpr int Q = M / 4;
+    SplitRadix<M / 2>::Run(in_re, in_im, 2 * stride, out_re, out_im);
+    SplitRadix<Q>::Run(in_re + stride, in_im + stride, 4 * stride,
+                       out_re + 2 * Q, out_im + 2 * Q);
+    SplitRadix<Q>::Run(in_re + 3 * stride, in_im + 3 * stride, 4 * stride,
+                       out_re + 3 * Q, out_im + 3 * Q);
+
+    const auto &tw = kTwiddles<M>;
+    for (int k = 0; k < Q; k++) {
+      const float o1r = out_re[2 * Q + k];
+      const float o1i = out_im[2 * Q + k];
+      const float o3r = out_re[3 * Q + k];
+      const float o3i = out_im[3 * Q + k];
+      const float ar = tw.w1r[k] * o1r - tw.w1i[k] * o1i;
+      const float ai = tw.w1r[k] * o1i + tw.w1i[k] * o1r;
+      const float br = tw.w3r[k] * o3r - tw.w3i[k] * o3i;
+      const float bi = tw.w3r[k] * o3i + tw.w3i[k] * o3r;
+      const float sr = ar + br;
+      const float si = ai + bi;
+      const float dr = ar - br;
+      const float di = ai - bi;
+      const float e0r = out_re[k];
+      const float e0i = out_im[k];
+      const float e1r = out_re[Q + k];
+      const float e1i = out_im[Q + k];
+      out_re[k] = e0r + sr;
+      out_im[k] = e0i + si;
+      out_re[2 * Q + k] = e0r - sr;
+      out_im[2 * Q + k] = e0i - si;
+      out_re[Q + k] = e1r + di;
+      out_im[Q + k] = e1i - dr;
+      out_re[3 * Q + k] = e1r - di;
+      out_im[3 * Q + k] = e1i + dr;
+    }
+  }
+};
+
+template <> struct SplitRadix<1> {
+  static void Run(const float *in_re, const float *in_im, int /*stride*/,
+                  float *out_re, float *out_im) {
+    out_re[0] = in_re[0];
+    out_im[0] = in_im[0];
+  }
+};
+
+template <> struct SplitRadix<2> {
+  static void Run(const float *in_re, const float *in_im, int stride,
+                  float *out_re, float *out_im) {
+    out_re[0] = in_re[0] + in_re[stride];
+    out_im[0] = in_im[0] + in_im[stride];
+    out_re[1] = in_re[0] - in_re[stride];
+    out_im[1] = in_im[0] - in_im[stride];
+  }
+};
+
+// Forward real FFT producing Size() / 2 + 1 bins as interleaved (re, im)
+// pairs, unscaled, the same layout and convention as kiss_fftr
+class RealFft {
+public:
+  virtual ~RealFft() = default;
+  virtual int Size() const = 0;
+  virtual void Forward(const float *in, float *out) = 0;
+};
+
+// The N real samples are packed as N / 2 complex ones, transformed with the
+// split-radix kernel and separated into the spectrum of the real signal.
+// Instances hold scratch buffers and must not be shared between threads.
+template <int N> class FixedRealFft final : public RealFft {
+  static_assert(N >= 8 && (N & (N - 1)) == 0, "N must be a power of two");
+  static constexpr int M = N / 2;
+
+public:
+  int Size() const override { return N; }
+
+  void Forward(const float *in, float *out) override {
+    for (int n = 0; n < M; n++) {
+      in_re_[n] = in[2 * n];
+      in_im_[n] = in[2 * n + 1];
+    }
+    SplitRadix<M>::Run(in_re_.data(), in_im_.data(), 1, z_re_.data(),
+                       z_im_.data());
+
+    out[0] = z_re_[0] + z_im_[0];
+    out[1] = 0.0f;
+    out[2 * M] = z_re_[0] - z_im_[0];
+    out[2 * M + 1] = 0.0f;
+    const auto &tw = kRealTwiddles<N>;
+    for (int k = 1; k < M; k++) {
+      // Even and odd sample spectra from Z[k] and conj(Z[M - k])
+      const float zr = z_re_[k];
+      const float zi = z_im_[k];
+      const float mr = z_re_[M - k];
+      const float mi = -z_im_[M - k];
+      const float er = 0.5f * (zr + mr);
+      const float ei = 0.5f * (zi + mi);
+      const float orr = 0.5f * (zi - mi);
+      const float oi = 0.5f * (mr - zr);
+      out[2 * k] = er + tw.r[k] * orr - tw.i[k] * oi;
+      out[2 * k + 1] = ei + tw.r[k] * oi + tw.i[k] * orr;
+    }
+  }
+
+private:
+  std::array<float, M> in_re_, in_im_, z_re_, z_im_;
+};
+
+// Specialized transform for the supported sizes, nullptr for the others
+inline std::unique_ptr<RealFft> CreateRealFft(int size) {
+  switch (size) {
+  case 256:
+    return std::make_unique<FixedRealFft<256>>();
+  case 512:
+    return std::make_unique<FixedRealFft<512>>();
+  case 1024:
+    return std::make_unique<FixedRealFft<1024>>();
+  default:
+    return nullptr;
+  }
+}
+
+} // namespace lip_sync::infer::fft
+
+#endif
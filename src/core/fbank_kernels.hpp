@@ -0,0 +1,383 @@
+/**
+ * @file fbank_kernels.hpp
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Vectorized per-frame kernels of the fbank fast path
+ * @version 0.1
+ * @date 2025-01-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __LIP_SYNC_FBANK_KERNELS_HPP_
+#define __LIP_SYNC_FBANK_KERNELS_HPP_
+
+#include <algorithm>
+#include <cmath>
+
+// MSVC implies FMA with /arch:AVX2 but does not define __FMA__
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define LIP_SYNC_FBANK_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIP_SYNC_FBANK_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define LIP_SYNC_FBANK_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace lip_sync::infer::kernels {
+
+// Instruction set the kernels were compiled for
+inline const char *InstructionSet() {
+#if defined(LIP_SYNC_FBANK_AVX2)
+  return "avx2";
+#elif defined(LIP_SYNC_FBANK_SSE2)
+  return "sse2";
+#elif defined(LIP_SYNC_FBANK_NEON)
+  return "neon";
+#else
+  return "scalar";
+#endif
+}
+
+#if defined(LIP_SYNC_FBANK_AVX2)
+inline float HorizontalSum(__m256 v) {
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v),
+                          _mm256_extractf128_ps(v, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return _mm_cvtss_f32(sum);
+}
+#elif defined(LIP_SYNC_FBANK_SSE2)
+inline float HorizontalSum(__m128 v) {
+  __m128 sum = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return _mm_cvtss_f32(sum);
+}
+#endif
+
+// sum(a[i] * b[i])
+inline float Dot(const float *a, const float *b, int n) {
+  int i = 0;
+  float sum = 0.0f;
+#if defined(LIP_SYNC_FBANK_AVX2)
+  __m256 acc = _mm256_setzero_ps();
+  for (; i + 8 <= n; i += 8) {
+    acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc);
+  }
+  sum = HorizontalSum(acc);
+#elif defined(LIP_SYNC_FBANK_SSE2)
+  __m128 acc = _mm_setzero_ps();
+  for (; i + 4 <= n; i += 4) {
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  }
+  sum = HorizontalSum(acc);
+#elif defined(LIP_SYNC_FBANK_NEON)
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  for (; i + 4 <= n; i += 4) {
+    acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+  }
+  float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+  sum = vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+  for (; i < n; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+inline float Sum(const float *x, int n) {
+  int i = 0;
+  float sum = 0.0f;
+#if defined(LIP_SYNC_FBANK_AVX2)
+  __m256 acc = _mm256_setzero_ps();
+  for (; i + 8 <= n; i += 8) {
+    acc = _mm256_add_ps(acc, _mm256_loadu_ps(x + i));
+  }
+  sum = HorizontalSum(acc);
+#elif defined(LIP_SYNC_FBANK_SSE2)
+  __m128 acc = _mm_setzero_ps();
+  for (; i + 4 <= n; i += 4) {
+    acc = _mm_add_ps(acc, _mm_loadu_ps(x + i));
+  }
+  sum = HorizontalSum(acc);
+#elif defined(LIP_SYNC_FBANK_NEON)
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  for (; i + 4 <= n; i += 4) {
+    acc = vaddq_f32(acc, vld1q_f32(x + i));
+  }
+  float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+  sum = vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+  for (; i < n; i++) {
+    sum += x[i];
+  }
+  return sum;
+}
+
+// x[i] += value
+inline void AddScalar(float *x, int n, float value) {
+  int i = 0;
+#if defined(LIP_SYNC_FBANK_AVX2)
+  const __m256 v = _mm256_set1_ps(value);
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), v));
+  }
+#elif defined(LIP_SYNC_FBANK_SSE2)
+  const __m128 v = _mm_set1_ps(value);
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), v));
+  }
+#elif defined(LIP_SYNC_FBANK_NEON)
+  const float32x4_t v = vdupq_n_f32(value);
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(x + i, vaddq_f32(vld1q_f32(x + i), v));
+  }
+#endif
+  for (; i < n; i++) {
+    x[i] += value;
+  }
+}
+
+// x[i] *= w[i]
+inline void Multiply(float *x, const float *w, int n) {
+  int i = 0;
+#if defined(LIP_SYNC_FBANK_AVX2)
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(
+        x + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(w + i)));
+  }
+#elif defined(LIP_SYNC_FBANK_SSE2)
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(x + i, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(w + i)));
+  }
+#elif defined(LIP_SYNC_FBANK_NEON)
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(x + i, vmulq_f32(vld1q_f32(x + i), vld1q_f32(w + i)));
+  }
+#endif
+  for (; i < n; i++) {
+    x[i] *= w[i];
+  }
+}
+
+// In place x[i] -= coeff * x[i - 1], x[0] *= 1 - coeff. Runs from the
+// end so every block reads inputs that have not been overwritten yet.
+inline void Preemphasis(float *x, int n, float coeff) {
+  int i = n;
+#if defined(LIP_SYNC_FBANK_AVX2)
+  const __m256 c = _mm256_set1_ps(coeff);
+  for (; i - 8 >= 1; i -= 8) {
+    __m256 cur = _mm256_loadu_ps(x + i - 8);
+    __m256 prev = _mm256_loadu_ps(x + i - 9);
+    _mm256_storeu_ps(x + i - 8, _mm256_fnmadd_ps(c, prev, cur));
+  }
+#elif defined(LIP_SYNC_FBANK_SSE2)
+  const __m128 c = _mm_set1_ps(coeff);
+  for (; i - 4 >= 1; i -= 4) {
+    __m128 cur = _mm_loadu_ps(x + i - 4);
+    __m128 prev = _mm_loadu_ps(x + i - 5);
+    _mm_storeu_ps(x + i - 4, _mm_sub_ps(cur, _mm_mul_ps(c, prev)));
+  }
+#elif defined(LIP_SYNC_FBANK_NEON)
+  const float32x4_t c = vdupq_n_f32(coeff);
+  for (; i - 4 >= 1; i -= 4) {
+    float32x4_t cur = vld1q_f32(x + i - 4);
+    float32x4_t prev = vld1q_f32(x + i - 5);
+    vst1q_f32(x + i - 4, vmlsq_f32(cur, c, prev));
+  }
+#endif
+  for (i = i - 1; i >= 1; i--) {
+    x[i] -= coeff * x[i - 1];
+  }
+  if (n > 0) {
+    x[0] *= 1.0f - coeff;
+  }
+}
+
+// out[i] = |spectrum[i]|^2 floored at epsilon, or |spectrum[i]| if !power.
+// spectrum holds interleaved (re, im) pairs.
+inline void PowerSpectrum(const float *spectrum, float *out, int n, bool power,
+                          float epsilon) {
+  int i = 0;
+  if (power) {
+#if defined(LIP_SYNC_FBANK_AVX2)
+    const __m256 eps = _mm256_set1_ps(epsilon);
+    for (; i + 8 <= n; i += 8) {
+      // Squares of 8 complex values, then pairwise sums within lanes
+      __m256 a = _mm256_loadu_ps(spectrum + 2 * i);
+      __m256 b = _mm256_loadu_ps(spectrum + 2 * i + 8);
+      __m256 sum = _mm256_hadd_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b));
+      // hadd interleaves the 128-bit lanes: a0 a1 b0 b1 -> a0 a1 a2 a3
+      sum = _mm256_castpd_ps(
+          _mm256_permute4x64_pd(_mm256_castps_pd(sum), 0xd8));
+      _mm256_storeu_ps(out + i, _mm256_max_ps(sum, eps));
+    }
+#elif defined(LIP_SYNC_FBANK_SSE2)
+    const __m128 eps = _mm_set1_ps(epsilon);
+    for (; i + 4 <= n; i += 4) {
+      __m128 a = _mm_loadu_ps(spectrum + 2 * i);
+      __m128 b = _mm_loadu_ps(spectrum + 2 * i + 4);
+      __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+      __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+      __m128 sum = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+      _mm_storeu_ps(out + i, _mm_max_ps(sum, eps));
+    }
+#elif defined(LIP_SYNC_FBANK_NEON)
+    const float32x4_t eps = vdupq_n_f32(epsilon);
+    for (; i + 4 <= n; i += 4) {
+      float32x4x2_t c = vld2q_f32(spectrum + 2 * i);
+      float32x4_t sum =
+          vmlaq_f32(vmulq_f32(c.val[0], c.val[0]), c.val[1], c.val[1]);
+      vst1q_f32(out + i, vmaxq_f32(sum, eps));
+    }
+#endif
+  }
+  for (; i < n; i++) {
+    float re = spectrum[2 * i];
+    float im = spectrum[2 * i + 1];
+    float value = re * re + im * im;
+    out[i] = power ? std::max(value, epsilon) : std::sqrt(value);
+  }
+}
+
+#if defined(LIP_SYNC_FBANK_AVX2) || defined(LIP_SYNC_FBANK_SSE2) ||            \
+    defined(LIP_SYNC_FBANK_NEON)
+// Cephes logf polynomial, within a few ulp of std::log for positive normal
+// inputs
+constexpr float kLogP0 = 7.0376836292e-2f;
+constexpr float kLogP1 = -1.1514610310e-1f;
+constexpr float kLogP2 = 1.1676998740e-1f;
+constexpr float kLogP3 = -1.2420140846e-1f;
+constexpr float kLogP4 = 1.4249322787e-1f;
+constexpr float kLogP5 = -1.6668057665e-1f;
+constexpr float kLogP6 = 2.0000714765e-1f;
+constexpr float kLogP7 = -2.4999993993e-1f;
+constexpr float kLogP8 = 3.3333331174e-1f;
+constexpr float kLogQ1 = -2.12194440e-4f;
+constexpr float kLogQ2 = 0.693359375f;
+constexpr float kSqrtHalf = 0.707106781186547524f;
+#endif
+
+#if defined(LIP_SYNC_FBANK_AVX2)
+inline __m256 Log(__m256 x) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  __m256i bits = _mm256_castps_si256(x);
+  __m256 e = _mm256_cvtepi32_ps(
+      _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+  // Mantissa in [0.5, 1)
+  x = _mm256_castsi256_ps(_mm256_or_si256(
+      _mm256_and_si256(bits, _mm256_set1_epi32(0x807fffff)),
+      _mm256_set1_epi32(0x3f000000)));
+
+  __m256 mask = _mm256_cmp_ps(x, _mm256_set1_ps(kSqrtHalf), _CMP_LT_OS);
+  __m256 tmp = _mm256_and_ps(x, mask);
+  x = _mm256_sub_ps(x, one);
+  e = _mm256_sub_ps(e, _mm256_and_ps(one, mask));
+  x = _mm256_add_ps(x, tmp);
+
+  __m256 z = _mm256_mul_ps(x, x);
+  __m256 y = _mm256_set1_ps(kLogP0);
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP1));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP2));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP3));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP4));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP5));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP6));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP7));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP8));
+  y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+  y = _mm256_fmadd_ps(e, _mm256_set1_ps(kLogQ1), y);
+  y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+  x = _mm256_add_ps(x, y);
+  return _mm256_fmadd_ps(e, _mm256_set1_ps(kLogQ2), x);
+}
+#elif defined(LIP_SYNC_FBANK_SSE2)
+inline __m128 Log(__m128 x) {
+  const __m128 one = _mm_set1_ps(1.0f);
+  __m128i bits = _mm_castps_si128(x);
+  __m128 e = _mm_cvtepi32_ps(
+      _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126)));
+  x = _mm_castsi128_ps(
+      _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x807fffff)),
+                   _mm_set1_epi32(0x3f000000)));
+
+  __m128 mask = _mm_cmplt_ps(x, _mm_set1_ps(kSqrtHalf));
+  __m128 tmp = _mm_and_ps(x, mask);
+  x = _mm_sub_ps(x, one);
+  e = _mm_sub_ps(e, _mm_and_ps(one, mask));
+  x = _mm_add_ps(x, tmp);
+
+  __m128 z = _mm_mul_ps(x, x);
+  __m128 y = _mm_set1_ps(kLogP0);
+  for (float p : {kLogP1, kLogP2, kLogP3, kLogP4, kLogP5, kLogP6, kLogP7,
+                  kLogP8}) {
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(p));
+  }
+  y = _mm_mul_ps(_mm_mul_ps(y, x), z);
+  y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(kLogQ1)));
+  y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+  x = _mm_add_ps(x, y);
+  return _mm_add_ps(x, _mm_mul_ps(e, _mm_set1_ps(kLogQ2)));
+}
+#elif defined(LIP_SYNC_FBANK_NEON)
+inline float32x4_t Log(float32x4_t x) {
+  const float32x4_t one = vdupq_n_f32(1.0f);
+  uint32x4_t bits = vreinterpretq_u32_f32(x);
+  float32x4_t e = vcvtq_f32_s32(vsubq_s32(
+      vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(126)));
+  x = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x807fffff)),
+                                      vdupq_n_u32(0x3f000000)));
+
+  uint32x4_t mask = vcltq_f32(x, vdupq_n_f32(kSqrtHalf));
+  float32x4_t tmp =
+      vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(x), mask));
+  x = vsubq_f32(x, one);
+  e = vsubq_f32(
+      e, vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(one), mask)));
+  x = vaddq_f32(x, tmp);
+
+  float32x4_t z = vmulq_f32(x, x);
+  float32x4_t y = vdupq_n_f32(kLogP0);
+  for (float p : {kLogP1, kLogP2, kLogP3, kLogP4, kLogP5, kLogP6, kLogP7,
+                  kLogP8}) {
+    y = vmlaq_f32(vdupq_n_f32(p), y, x);
+  }
+  y = vmulq_f32(vmulq_f32(y, x), z);
+  y = vmlaq_f32(y, e, vdupq_n_f32(kLogQ1));
+  y = vmlsq_f32(y, z, vdupq_n_f32(0.5f));
+  x = vaddq_f32(x, y);
+  return vmlaq_f32(x, e, vdupq_n_f32(kLogQ2));
+}
+#endif
+
+// x[i] = log(max(x[i], floor)), floor must be a positive normal number
+inline void LogFloor(float *x, int n, float floor) {
+  int i = 0;
+#if defined(LIP_SYNC_FBANK_AVX2)
+  const __m256 f = _mm256_set1_ps(floor);
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(x + i, Log(_mm256_max_ps(_mm256_loadu_ps(x + i), f)));
+  }
+#elif defined(LIP_SYNC_FBANK_SSE2)
+  const __m128 f = _mm_set1_ps(floor);
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(x + i, Log(_mm_max_ps(_mm_loadu_ps(x + i), f)));
+  }
+#elif defined(LIP_SYNC_FBANK_NEON)
+  const float32x4_t f = vdupq_n_f32(floor);
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(x + i, Log(vmaxq_f32(vld1q_f32(x + i), f)));
+  }
+#endif
+  for (; i < n; i++) {
+    x[i] = std::log(std::max(x[i], floor));
+  }
+}
+
+} // namespace lip_sync::infer::kernels
+
+#endif
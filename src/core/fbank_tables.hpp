@@ -0,0 +1,197 @@
+/**
+ * @file fbank_tables.hpp
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Fbank tables evaluated at compile time
+ * @version 0.1
+ * @date 2025-01-05
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __LIP_SYNC_FBANK_TABLES_HPP_
+#define __LIP_SYNC_FBANK_TABLES_HPP_
+
+#include <array>
+
+namespace lip_sync::infer::tables {
+
+// constexpr replacements for the <cmath> functions the tables need, in double
+// precision so that the float tables round the same as the runtime ones
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kLn2 = 0.69314718055994530942;
+
+constexpr double Cos(double x) {
+  // Reduce to [-pi, pi], then Taylor series
+  const double turns = x / (2.0 * kPi);
+  const long long n =
+      static_cast<long long>(turns < 0.0 ? turns - 0.5 : turns + 0.5);
+  x -= 2.0 * kPi * static_cast<double>(n);
+  double term = 1.0;
+  double sum = 1.0;
+  for (int k = 1; k < 30; k++) {
+    term *= -x * x / ((2 * k - 1) * (2 * k));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double Sin(double x) { return Cos(x - kPi / 2.0); }
+
+constexpr double Log(double x) {
+  // x = m * 2^e with m in [1, 2), log(m) = 2 atanh((m - 1) / (m + 1))
+  int e = 0;
+  while (x >= 2.0) {
+    x /= 2.0;
+    e++;
+  }
+  while (x < 1.0) {
+    x *= 2.0;
+    e--;
+  }
+  const double t = (x - 1.0) / (x + 1.0);
+  double power = t;
+  double sum = 0.0;
+  for (int k = 0; k < 30; k++) {
+    sum += power / (2 * k + 1);
+    power *= t * t;
+  }
+  return 2.0 * sum + e * kLn2;
+}
+
+constexpr double Exp(double x) {
+  // x = n ln2 + r with |r| <= ln2 / 2, then Taylor series of exp(r)
+  long long n =
+      static_cast<long long>(x < 0.0 ? x / kLn2 - 0.5 : x / kLn2 + 0.5);
+  const double r = x - static_cast<double>(n) * kLn2;
+  double term = 1.0;
+  double sum = 1.0;
+  for (int k = 1; k < 25; k++) {
+    term *= r / k;
+    sum += term;
+  }
+  for (; n > 0; n--) {
+    sum *= 2.0;
+  }
+  for (; n < 0; n++) {
+    sum /= 2.0;
+  }
+  return sum;
+}
+
+constexpr double Pow(double x, double y) {
+  return x > 0.0 ? Exp(y * Log(x)) : 0.0;
+}
+
+// Production configuration: 16 kHz audio, 25 ms povey window padded to a
+// 512-point FFT, 80 mel bins from 20 Hz up to Nyquist, no VTLN warping
+struct DefaultFbank {
+  static constexpr float kSampleFrequency = 16000.0f;
+  static constexpr int kFrameLength = 400;
+  static constexpr int kPaddedSize = 512;
+  static constexpr int kNumBins = kPaddedSize / 2 + 1;
+  static constexpr int kNumMelBins = 80;
+  static constexpr float kLowFreq = 20.0f;
+  static constexpr float kHighFreq = kSampleFrequency / 2.0f;
+};
+
+constexpr std::array<float, DefaultFbank::kFrameLength> MakePoveyWindow() {
+  constexpr int size = DefaultFbank::kFrameLength;
+  std::array<float, size> window{};
+  for (int i = 0; i < size; i++) {
+    const double hanning = 0.5 - 0.5 * Cos(2.0 * kPi * i / (size - 1));
+    window[i] = static_cast<float>(Pow(hanning, 0.85));
+  }
+  return window;
+}
+
+constexpr double MelScale(double freq) {
+  return 1127.0 * Log(1.0 + freq / 700.0);
+}
+
+inline constexpr double kMelLow = MelScale(DefaultFbank::kLowFreq);
+inline constexpr double kMelDelta =
+    (MelScale(DefaultFbank::kHighFreq) - kMelLow) /
+    (DefaultFbank::kNumMelBins + 1);
+
+// Triangular filter weight of mel bin `bin` at the FFT bin of mel value
+// `mel`, the same construction as FbankComputer::GetMelBanks
+constexpr double MelWeight(int bin, double mel) {
+  const double left = kMelLow + bin * kMelDelta;
+  const double center = kMelLow + (bin + 1) * kMelDelta;
+  const double right = kMelLow + (bin + 2) * kMelDelta;
+  if (mel <= left || mel >= right) {
+    return 0.0;
+  }
+  return mel <= center ? (mel - left) / (center - left)
+                       : (right - mel) / (right - center);
+}
+
+constexpr std::array<double, DefaultFbank::kNumBins> MakeBinMels() {
+  std::array<double, DefaultFbank::kNumBins> mels{};
+  for (int j = 0; j < DefaultFbank::kNumBins; j++) {
+    mels[j] = MelScale(static_cast<double>(j) * DefaultFbank::kSampleFrequency /
+                       DefaultFbank::kPaddedSize);
+  }
+  return mels;
+}
+
+inline constexpr auto kBinMels = MakeBinMels();
+
+constexpr int CountMelWeights() {
+  int count = 0;
+  for (int i = 0; i < DefaultFbank::kNumMelBins; i++) {
+    int first = -1;
+    int last = -1;
+    for (int j = 0; j < DefaultFbank::kNumBins; j++) {
+      if (MelWeight(i, kBinMels[j]) != 0.0) {
+        first = first < 0 ? j : first;
+        last = j;
+      }
+    }
+    count += first < 0 ? 0 : last - first + 1;
+  }
+  return count;
+}
+
+// Sparse mel banks in the layout of FbankComputer: filter i has num_bins[i]
+// weights at offset[i], applied from FFT bin first_bin[i]
+template <int NumWeights> struct MelTable {
+  std::array<int, DefaultFbank::kNumMelBins> first_bin{};
+  std::array<int, DefaultFbank::kNumMelBins> num_bins{};
+  std::array<int, DefaultFbank::kNumMelBins> offset{};
+  std::array<float, NumWeights> weights{};
+};
+
+template <int NumWeights> constexpr MelTable<NumWeights> MakeMelTable() {
+  MelTable<NumWeights> table{};
+  int offset = 0;
+  for (int i = 0; i < DefaultFbank::kNumMelBins; i++) {
+    int first = DefaultFbank::kNumBins;
+    int last = -1;
+    for (int j = 0; j < DefaultFbank::kNumBins; j++) {
+      if (MelWeight(i, kBinMels[j]) != 0.0) {
+        first = first > j ? j : first;
+        last = j;
+      }
+    }
+    if (last < 0) {
+      first = 0;
+    }
+    table.first_bin[i] = first;
+    table.num_bins[i] = last - first + 1;
+    table.offset[i] = offset;
+    for (int j = first; j <= last; j++) {
+      table.weights[offset++] =
+          static_cast<float>(MelWeight(i, kBinMels[j]));
+    }
+  }
+  return table;
+}
+
+inline constexpr auto kPoveyWindow = MakePoveyWindow();
+inline constexpr auto kMelTable = MakeMelTable<CountMelWeights()>();
+
+} // namespace lip_sync::infer::tables
+
+#endif
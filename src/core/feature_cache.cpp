@@ -0,0 +1,237 @@
+/**
+ * @file feature_cache.cpp
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Content addressed cache of encoder features
+ * @version 0.1
+ * @date 2025-01-08
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "feature_cache.hpp"
+#include "feature_file.hpp"
+#include "logger/logger.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace lip_sync::infer {
+
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t read64(const uint8_t *p) {
+  uint64_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint64_t mixRound(uint64_t acc, uint64_t input) {
+  acc += input * kPrime2;
+  return rotl(acc, 31) * kPrime1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t lane) {
+  acc ^= mixRound(0, lane);
+  return acc * kPrime1 + kPrime4;
+}
+
+// Bumped whenever the features change, so that entries written by older
+// versions are never read back
+constexpr uint32_t kFormatVersion = 1;
+
+size_t featureBytes(const std::vector<cv::Mat> &features) {
+  size_t bytes = 0;
+  for (const auto &feature : features) {
+    bytes += feature.total() * feature.elemSize();
+  }
+  return bytes;
+}
+
+} // namespace
+
+uint64_t FeatureCache::hash(const void *data, size_t size, uint64_t seed) {
+  const auto *p = static_cast<const uint8_t *>(data);
+  const uint8_t *end = p + size;
+
+  // Four independent lanes over 32 byte stripes
+  uint64_t h;
+  if (size >= 32) {
+    uint64_t v1 = seed + kPrime1 + kPrime2;
+    uint64_t v2 = seed + kPrime2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - kPrime1;
+    for (; end - p >= 32; p += 32) {
+      v1 = mixRound(v1, read64(p));
+      v2 = mixRound(v2, read64(p + 8));
+      v3 = mixRound(v3, read64(p + 16));
+      v4 = mixRound(v4, read64(p + 24));
+    }
+    h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+    h = mergeRound(h, v1);
+    h = mergeRound(h, v2);
+    h = mergeRound(h, v3);
+    h = mergeRound(h, v4);
+  } else {
+    h = seed + kPrime3;
+  }
+  h += size;
+
+  for (; end - p >= 8; p += 8) {
+    h ^= mixRound(0, read64(p));
+    h = rotl(h, 27) * kPrime1 + kPrime4;
+  }
+  for (; p < end; ++p) {
+    h ^= *p * kPrime3;
+    h = rotl(h, 11) * kPrime1;
+  }
+
+  h ^= h >> 33;
+  h *= kPrime2;
+  h ^= h >> 29;
+  h *= kPrime3;
+  h ^= h >> 32;
+  return h;
+}
+
+uint64_t FeatureCache::modelKey(const std::string &modelPath,
+                                const FbankConfig &fbankConfig,
+                                const WeNetConfig &wenetConfig) {
+  std::ifstream file(modelPath, std::ios::binary);
+  if (!file) {
+    return 0;
+  }
+  uint64_t key = kFormatVersion;
+  std::vector<char> block(1 << 20);
+  while (file) {
+    file.read(block.data(), block.size());
+    key = hash(block.data(), file.gcount(), key);
+  }
+
+  const double params[] = {static_cast<double>(fbankConfig.numMelBins),
+                           static_cast<double>(fbankConfig.frameLength),
+                           static_cast<double>(fbankConfig.frameShift),
+                           static_cast<double>(fbankConfig.useLogFbank),
+                           static_cast<double>(fbankConfig.usePower),
+                           fbankConfig.dither,
+                           fbankConfig.energyFloor,
+                           static_cast<double>(fbankConfig.sampleFrequency),
+                           static_cast<double>(wenetConfig.framesStride),
+                           static_cast<double>(wenetConfig.numFeatures),
+                           static_cast<double>(wenetConfig.slidingStep),
+                           static_cast<double>(wenetConfig.incremental),
+                           static_cast<double>(wenetConfig.silenceCache),
+                           wenetConfig.silenceTolerance};
+  return hash(params, sizeof(params), key);
+}
+
+FeatureCache::FeatureCache(size_t capacityBytes, std::string directory,
+                           uint64_t modelKey)
+    : capacityBytes_(capacityBytes), directory_(std::move(directory)),
+      modelKey_(modelKey) {}
+
+uint64_t FeatureCache::key(const std::vector<float> &samples) const {
+  return hash(samples.data(), samples.size() * sizeof(float), modelKey_);
+}
+
+FeatureCache::Features FeatureCache::get(uint64_t key) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = index_.find(key);
+    if (iter != index_.end()) {
+      entries_.splice(entries_.begin(), entries_, iter->second);
+      return iter->second->features;
+    }
+  }
+
+  // The file is read outside of the lock, other clips stay available
+  auto features = load(key);
+  if (features) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    insert(key, features);
+  }
+  return features;
+}
+
+void FeatureCache::put(uint64_t key, std::vector<cv::Mat> features) {
+  auto shared =
+      std::make_shared<const std::vector<cv::Mat>>(std::move(features));
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    insert(key, shared);
+  }
+  store(key, *shared);
+}
+
+size_t FeatureCache::sizeBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return sizeBytes_;
+}
+
+void FeatureCache::insert(uint64_t key, Features features) {
+  auto iter = index_.find(key);
+  if (iter != index_.end()) {
+    sizeBytes_ -= iter->second->bytes;
+    entries_.erase(iter->second);
+    index_.erase(iter);
+  }
+
+  // Clips larger than the whole budget are only kept on disk
+  const size_t bytes = featureBytes(*features);
+  if (bytes > capacityBytes_) {
+    return;
+  }
+  while (sizeBytes_ + bytes > capacityBytes_) {
+    sizeBytes_ -= entries_.back().bytes;
+    index_.erase(entries_.back().key);
+    entries_.pop_back();
+  }
+  entries_.push_front(Entry{key, std::move(features), bytes});
+  index_[key] = entries_.begin();
+  sizeBytes_ += bytes;
+}
+
+std::string FeatureCache::filePath(uint64_t key) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.feat",
+                static_cast<unsigned long long>(key));
+  return (std::filesystem::path(directory_) / name).string();
+}
+
+FeatureCache::Features FeatureCache::load(uint64_t key) const {
+  if (directory_.empty()) {
+    return nullptr;
+  }
+  // Loaded rather than mapped, the features outlive the file object
+  auto file = FeatureFile::open(filePath(key), false);
+  if (!file) {
+    return nullptr;
+  }
+  if (file->key() != key || file->features().empty()) {
+    LOGGER_WARN("Ignoring feature cache file {} of another clip",
+                filePath(key));
+    return nullptr;
+  }
+  return std::make_shared<const std::vector<cv::Mat>>(file->features());
+}
+
+void FeatureCache::store(uint64_t key,
+                         const std::vector<cv::Mat> &features) const {
+  if (directory_.empty() || features.empty()) {
+    return;
+  }
+  const std::string path = filePath(key);
+  std::error_code error;
+  if (!std::filesystem::exists(path, error)) {
+    FeatureFile::write(path, features, {}, key, modelKey_);
+  }
+}
+
+} // namespace lip_sync::infer
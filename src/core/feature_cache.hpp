@@ -0,0 +1,98 @@
+/**
+ * @file feature_cache.hpp
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Content addressed cache of encoder features
+ * @version 0.1
+ * @date 2025-01-08
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __LIP_SYNC_FEATURE_CACHE_HPP_
+#define __LIP_SYNC_FEATURE_CACHE_HPP_
+
+#include "types.hpp"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <opencv2/core.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lip_sync::infer {
+
+/**
+ * @brief Encoder features of whole clips, keyed by a hash of the
+ * preprocessed samples and of the encoder model identity. The most recently
+ * used clips are kept in memory up to a byte budget. With a directory every
+ * clip is also written to disk, one file per key, and read back on a memory
+ * miss, so the cache survives restarts. Thread safe.
+ */
+class FeatureCache {
+public:
+  using Features = std::shared_ptr<const std::vector<cv::Mat>>;
+
+  /**
+   * @param capacityBytes memory budget of the features, 0 keeps nothing in
+   * memory
+   * @param directory directory of the disk tier, empty to disable it
+   * @param modelKey identity of the encoder, see modelKey()
+   */
+  FeatureCache(size_t capacityBytes, std::string directory, uint64_t modelKey);
+
+  /**
+   * @brief Key of a clip from its preprocessed samples
+   */
+  uint64_t key(const std::vector<float> &samples) const;
+
+  /**
+   * @brief Features of a clip, nullptr on a miss of both tiers
+   */
+  Features get(uint64_t key);
+
+  void put(uint64_t key, std::vector<cv::Mat> features);
+
+  size_t sizeBytes() const;
+
+  /**
+   * @brief Identity of an encoder: its model file content and the
+   * configuration the features depend on. 0 if the model cannot be read.
+   */
+  static uint64_t modelKey(const std::string &modelPath,
+                           const FbankConfig &fbankConfig,
+                           const WeNetConfig &wenetConfig);
+
+  /**
+   * @brief Fast non-cryptographic 64 bit hash, several GB/s on 64 bit
+   * targets
+   */
+  static uint64_t hash(const void *data, size_t size, uint64_t seed = 0);
+
+private:
+  struct Entry {
+    uint64_t key;
+    Features features;
+    size_t bytes;
+  };
+
+  void insert(uint64_t key, Features features);
+  Features load(uint64_t key) const;
+  void store(uint64_t key, const std::vector<cv::Mat> &features) const;
+  std::string filePath(uint64_t key) const;
+
+  size_t capacityBytes_;
+  std::string directory_;
+  uint64_t modelKey_;
+
+  // Most recently used first
+  std::list<Entry> entries_;
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+  size_t sizeBytes_ = 0;
+  mutable std::mutex mutex_;
+};
+} // namespace lip_sync::infer
+
+#endif
@@ -9,11 +9,35 @@
  *
  */
 #include "feature_extractor.hpp"
+#include "logger/logger.hpp"
+#include <cmath>
 
 namespace lip_sync::infer {
+
+// Number of neighbouring features on each side of an audio chunk
+constexpr int kSliceWindowSize = 8;
+
+// Frame subsampling of the encoder and outputs of a single encoder run
+constexpr int kEncoderSubsampling = 4;
+constexpr int kEncoderOutputFrames = 16;
+constexpr int kEncoderOutputDim = 512;
+
+// Fbank frames between consecutive incremental encoder runs
+constexpr int kEncoderRunShift = kEncoderSubsampling * kEncoderOutputFrames;
+
+// Position offset given to the first encoder run, and the size of the
+// positional encoding table the offset has to stay within
+constexpr int kEncoderOffset = 100;
+constexpr int kEncoderMaxPosition = 5000;
+
+// Windows collected before they are encoded, bounds the memory of long clips
+constexpr size_t kMaxPendingWindows = 64;
+
 FeatureExtractor::FeatureExtractor(const FbankConfig &fbankConfig,
                                    const WeNetConfig &wenetConfig)
-    : fbankConfig_(fbankConfig), wenetConfig_(wenetConfig) {}
+    : fbankConfig_(fbankConfig), wenetConfig_(wenetConfig) {
+  encoderOutput_.setParams(WeNetEncoderOutput{});
+}
 
 bool FeatureExtractor::initialize() {
   // Initialize FbankComputer
@@ -28,14 +52,93 @@ bool FeatureExtractor::initialize() {
   opts.use_power = fbankConfig_.usePower;
 
   fbankComputer_ = std::make_unique<FbankComputer>(opts);
+  if (fbankComputer_->Dim() != wenetConfig_.numFeatures) {
+    LOGGER_ERROR("Fbank dimension {} does not match WeNet features {}",
+                 fbankComputer_->Dim(), wenetConfig_.numFeatures);
+    return false;
+  }
+
+  // Initialize caches
+  attCache_ = cv::Mat::zeros(3 * 8 * 16 * 128, 1, CV_32F);
+  cnnCache_ = cv::Mat::zeros(3 * 1 * 512 * 14, 1, CV_32F);
+
+  // Windowed encoding handed elsewhere does not need an encoder here
+  if (windowEncoder_ && !wenetConfig_.incremental) {
+    return true;
+  }
 
   // Initialize WeNet encoder
   AlgoBase encoderAlgoBase;
   encoderAlgoBase.name = "wenet_encoder";
   encoderAlgoBase.modelPath = wenetConfig_.modelPath;
+  encoderAlgoBase.session = wenetConfig_.session;
+  encoderAlgoBase.replica = wenetConfig_.replica;
 
   wenetEncoder_ = std::make_unique<dnn::WeNetEncoderInference>(encoderAlgoBase);
-  return wenetEncoder_->initialize();
+  if (!wenetEncoder_->initialize()) {
+    return false;
+  }
+
+  batchSize_ = std::max(wenetConfig_.batchSize, 1);
+  if (batchSize_ > 1 && !wenetEncoder_->supportsBatch()) {
+    LOGGER_WARN("WeNet encoder model has a fixed batch size or dynamic "
+                "cache shapes, batching disabled");
+    batchSize_ = 1;
+  }
+  return initSilenceCache();
+}
+
+bool FeatureExtractor::initSilenceCache() {
+  silenceFrame_.clear();
+  silenceFeature_ = cv::Mat();
+  if (!wenetConfig_.silenceCache) {
+    return true;
+  }
+  // Dithered silence differs from window to window
+  if (fbankConfig_.dither != 0.0f) {
+    LOGGER_INFO("Fbank dither is enabled, silence cache disabled");
+    return true;
+  }
+
+  std::vector<float> silence(fbankComputer_->FrameLengthSamples(), 0.0f);
+  fbankComputer_->Compute(silence.data(), silence.size(), silenceFrame_);
+
+  const int dim = wenetConfig_.numFeatures;
+  cv::Mat chunkFeat(wenetConfig_.framesStride * dim, 1, CV_32F);
+  for (int i = 0; i < wenetConfig_.framesStride; ++i) {
+    std::memcpy(chunkFeat.ptr<float>() + i * dim, silenceFrame_.data(),
+                dim * sizeof(float));
+  }
+
+  try {
+    silenceFeature_ = encodeChunk(chunkFeat);
+  } catch (const std::exception &e) {
+    LOGGER_ERROR("Failed to encode the silence window: {}", e.what());
+    silenceFrame_.clear();
+    return false;
+  }
+  return true;
+}
+
+bool FeatureExtractor::isSilentWindow(const cv::Mat &chunkFeat) const {
+  if (silenceFeature_.empty()) {
+    return false;
+  }
+  const int dim = wenetConfig_.numFeatures;
+  const float tolerance = wenetConfig_.silenceTolerance;
+  const float *data = chunkFeat.ptr<float>();
+  for (int i = 0; i < wenetConfig_.framesStride; ++i) {
+    for (int j = 0; j < dim; ++j) {
+      if (std::abs(data[i * dim + j] - silenceFrame_[j]) > tolerance) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void FeatureExtractor::setWindowEncoder(WindowEncoder encoder) {
+  windowEncoder_ = std::move(encoder);
 }
 
 std::vector<std::vector<float>>
@@ -45,153 +148,380 @@ FeatureExtractor::computeFbank(const std::vector<float> &audio) {
 
 std::vector<cv::Mat> FeatureExtractor::extractWenetFeatures(
     const std::vector<std::vector<float>> &fbankFeatures) {
-  std::vector<cv::Mat> wenetFeatures;
-  const int fbankFeatureLength = fbankFeatures.size();
+  // Same windows as a stream that received all frames at once
+  StreamState state;
+  state.fbankFrames.reserve(fbankFeatures.size() * wenetConfig_.numFeatures);
+  for (const auto &frame : fbankFeatures) {
+    state.fbankFrames.insert(state.fbankFrames.end(), frame.begin(),
+                             frame.end());
+  }
+  state.numFbankFrames = fbankFeatures.size();
+  state.finished = true;
+  encodeStreamWindows(state);
+  return std::move(state.wenetFeatures);
+}
 
-  // Initialize caches
-  cv::Mat attCache = cv::Mat::zeros(3 * 8 * 16 * 128, 1, CV_32F);
-  cv::Mat cnnCache = cv::Mat::zeros(3 * 1 * 512 * 14, 1, CV_32F);
-  int offset = 100;
-
-  // Process features using sliding window
-  int start = 0;
-  int end = 0;
-
-  while (end < fbankFeatureLength) {
-    end = start + wenetConfig_.framesStride;
-
-    // Prepare chunk feature
-    cv::Mat chunkFeat;
-    if (end <= fbankFeatureLength) {
-      chunkFeat = cv::Mat(wenetConfig_.framesStride * wenetConfig_.numFeatures,
-                          1, CV_32F);
-
-      for (int i = start; i < end; i++) {
-        if (i < fbankFeatureLength) {
-          std::memcpy(chunkFeat.ptr<float>() +
-                          (i - start) * wenetConfig_.numFeatures,
-                      fbankFeatures[i].data(),
-                      wenetConfig_.numFeatures * sizeof(float));
-        } else {
-          std::memset(chunkFeat.ptr<float>() +
-                          (i - start) * wenetConfig_.numFeatures,
-                      0, wenetConfig_.numFeatures * sizeof(float));
-        }
-      }
+std::vector<cv::Mat>
+FeatureExtractor::encodeWindows(const std::vector<cv::Mat> &chunkFeats) {
+  std::vector<cv::Mat> features(chunkFeats.size());
+
+  // Silent windows need no encoder run, the others are batched
+  std::vector<size_t> pending;
+  pending.reserve(chunkFeats.size());
+  for (size_t i = 0; i < chunkFeats.size(); ++i) {
+    if (isSilentWindow(chunkFeats[i])) {
+      features[i] = silenceFeature_;
     } else {
-      chunkFeat = cv::Mat(wenetConfig_.framesStride * wenetConfig_.numFeatures,
-                          1, CV_32F, cv::Scalar(0));
-      for (int i = start; i < fbankFeatureLength; i++) {
-        std::memcpy(
-            chunkFeat.ptr<float>() + (i - start) * wenetConfig_.numFeatures,
-            fbankFeatures[i].data(), wenetConfig_.numFeatures * sizeof(float));
-      }
+      pending.push_back(i);
+    }
+  }
+
+  const int numFeatures = wenetConfig_.framesStride * wenetConfig_.numFeatures;
+  for (size_t first = 0; first < pending.size(); first += batchSize_) {
+    const int batchSize =
+        std::min<int>(batchSize_, static_cast<int>(pending.size() - first));
+    if (batchSize == 1) {
+      features[pending[first]] = encodeChunk(chunkFeats[pending[first]]);
+      continue;
+    }
+
+    // Stack the windows into one [K, framesStride, numFeatures] chunk, a
+    // view of the buffer kept for the largest batch
+    int sizes[] = {batchSize, wenetConfig_.framesStride,
+                   wenetConfig_.numFeatures};
+    if (encoderBatch_.total() < static_cast<size_t>(batchSize_) * numFeatures) {
+      encoderBatch_.create(batchSize_ * numFeatures, 1, CV_32F);
+    }
+    cv::Mat batch(3, sizes, CV_32F, encoderBatch_.ptr<float>());
+    for (int k = 0; k < batchSize; ++k) {
+      std::memcpy(batch.ptr<float>() + k * numFeatures,
+                  chunkFeats[pending[first + k]].ptr<float>(),
+                  numFeatures * sizeof(float));
     }
 
-    WeNetEncoderInput encoderInput;
-    encoderInput.chunk = chunkFeat;
-    encoderInput.offset = offset;
-    encoderInput.attCache = attCache;
-    encoderInput.cnnCache = cnnCache;
+    const auto &encoderOutput =
+        runEncoder(batch, kEncoderOffset, attCache_, cnnCache_, batchSize);
+    for (int k = 0; k < batchSize; ++k) {
+      features[pending[first + k]] =
+          cv::Mat(kEncoderOutputFrames, kEncoderOutputDim, CV_32F,
+                  const_cast<float *>(encoderOutput.data.data()) +
+                      k * kEncoderOutputFrames * kEncoderOutputDim)
+              .clone();
+    }
+  }
+  return features;
+}
 
-    AlgoInput input;
-    input.setParams(encoderInput);
+cv::Mat FeatureExtractor::encodeChunk(const cv::Mat &chunkFeat) {
+  const auto &encoderOutput =
+      runEncoder(chunkFeat, kEncoderOffset, attCache_, cnnCache_);
 
-    AlgoOutput output;
-    WeNetEncoderOutput wenetEncoderOutput;
-    output.setParams(wenetEncoderOutput);
+  const float *srcData = encoderOutput.data.data();
+  cv::Mat outputFeature(kEncoderOutputFrames, kEncoderOutputDim, CV_32F);
 
-    if (!wenetEncoder_->infer(input, output)) {
-      throw std::runtime_error("Failed to process WeNet encoder");
+  for (int i = 0; i < kEncoderOutputFrames; i++) {
+    float *dstRow = outputFeature.ptr<float>(i);
+    for (int j = 0; j < kEncoderOutputDim; j++) {
+      dstRow[j] = srcData[i * kEncoderOutputDim + j];
     }
+  }
+  return outputFeature;
+}
 
-    auto *encoderOutput = output.getParams<WeNetEncoderOutput>();
-    if (encoderOutput) {
-      const float *srcData = encoderOutput->data.data();
-      cv::Mat outputFeature(16, 512, CV_32F);
+const WeNetEncoderOutput &
+FeatureExtractor::runEncoder(const cv::Mat &chunkFeat, int offset,
+                             const cv::Mat &attCache, const cv::Mat &cnnCache,
+                             int batchSize) {
+  WeNetEncoderInput encoderInput;
+  encoderInput.chunk = chunkFeat;
+  encoderInput.offset = offset;
+  encoderInput.attCache = attCache;
+  encoderInput.cnnCache = cnnCache;
+
+  AlgoInput input;
+  input.setParams(encoderInput);
+
+  // The output buffers are kept between runs, the encoder writes into them
+  if (!wenetEncoder_->infer(input, encoderOutput_)) {
+    throw std::runtime_error("Failed to process WeNet encoder");
+  }
 
-      for (int i = 0; i < 16; i++) {
-        float *dstRow = outputFeature.ptr<float>(i);
-        for (int j = 0; j < 512; j++) {
-          dstRow[j] = srcData[i * 512 + j];
-        }
-      }
-      wenetFeatures.push_back(outputFeature);
+  auto *encoderOutput = encoderOutput_.getParams<WeNetEncoderOutput>();
+  if (!encoderOutput ||
+      encoderOutput->data.size() !=
+          static_cast<size_t>(batchSize) * kEncoderOutputFrames *
+              kEncoderOutputDim) {
+    throw std::runtime_error("Unexpected WeNet encoder output");
+  }
+  return *encoderOutput;
+}
+
+bool FeatureExtractor::encodeIncremental(StreamState &state) {
+  const int stride = wenetConfig_.framesStride;
+  const int lastRun =
+      (state.windowStart / kEncoderSubsampling + kEncoderOutputFrames - 1) /
+      kEncoderOutputFrames;
+
+  while (state.nextEncoderRun <= lastRun) {
+    // A run reads framesStride frames from its start, the last frames
+    // overlap with the next run for the subsampling context. Past the end
+    // of a finished stream they are zero padded.
+    const int runStart = state.nextEncoderRun * kEncoderRunShift;
+    if (!state.finished && runStart + stride > state.numFbankFrames) {
+      return false;
+    }
+
+    if (state.attCache.empty()) {
+      state.attCache = attCache_.clone();
+      state.cnnCache = cnnCache_.clone();
+      state.encoderOffset = kEncoderOffset;
     }
 
-    start += wenetConfig_.slidingStep;
+    const int start = runStart - state.fbankOffset;
+    cv::Mat chunkFeat =
+        prepareChunkFeature(state.fbankFrames, start, start + stride);
+
+    const auto &output = runEncoder(chunkFeat, state.encoderOffset,
+                                    state.attCache, state.cnnCache);
+    if (output.RAttCache.size() != state.attCache.total() ||
+        output.RCNNCache.size() != state.cnnCache.total()) {
+      throw std::runtime_error("Unexpected WeNet encoder cache size");
+    }
+    std::memcpy(state.attCache.ptr<float>(), output.RAttCache.data(),
+                output.RAttCache.size() * sizeof(float));
+    std::memcpy(state.cnnCache.ptr<float>(), output.RCNNCache.data(),
+                output.RCNNCache.size() * sizeof(float));
+    state.encoderOffset =
+        std::min(state.encoderOffset + kEncoderOutputFrames,
+                 kEncoderMaxPosition - kEncoderOutputFrames);
+
+    state.encoderBlocks.push_back(
+        cv::Mat(kEncoderOutputFrames, kEncoderOutputDim, CV_32F,
+                const_cast<float *>(output.data.data()))
+            .clone());
+    state.nextEncoderRun++;
   }
+  return true;
+}
 
-  return wenetFeatures;
+cv::Mat FeatureExtractor::getIncrementalFeature(const StreamState &state,
+                                                int windowStart) {
+  // The encoder output at index i covers the fbank frames starting at
+  // i * kEncoderSubsampling
+  const int first = windowStart / kEncoderSubsampling;
+  cv::Mat feature(kEncoderOutputFrames, kEncoderOutputDim, CV_32F);
+  for (int i = 0; i < kEncoderOutputFrames; ++i) {
+    const int index = first + i;
+    const cv::Mat &block =
+        state.encoderBlocks[index / kEncoderOutputFrames - state.blockOffset];
+    block.row(index % kEncoderOutputFrames).copyTo(feature.row(i));
+  }
+  return feature;
 }
 
 cv::Mat FeatureExtractor::prepareChunkFeature(
-    const std::vector<std::vector<float>> &fbankFeatures, int start, int end) {
+    const std::vector<float> &fbankFrames, int start, int end) {
+
+  const int dim = wenetConfig_.numFeatures;
+  const int featureLength = fbankFrames.size() / dim;
+  cv::Mat chunkFeat(wenetConfig_.framesStride * dim, 1, CV_32F,
+                    cv::Scalar(0));
+
+  // Rows are contiguous, frames past the end stay zero
+  const int numRows = std::min(end, featureLength) - start;
+  if (numRows > 0) {
+    std::memcpy(chunkFeat.ptr<float>(), fbankFrames.data() + start * dim,
+                numRows * dim * sizeof(float));
+  }
 
-  const int featureLength = fbankFeatures.size();
-  cv::Mat chunkFeat(wenetConfig_.framesStride * wenetConfig_.numFeatures, 1,
-                    CV_32F, cv::Scalar(0));
+  return chunkFeat;
+}
 
-  for (int i = start; i < std::min(end, featureLength); i++) {
-    std::memcpy(chunkFeat.ptr<float>() + (i - start) * wenetConfig_.numFeatures,
-                fbankFeatures[i].data(),
-                wenetConfig_.numFeatures * sizeof(float));
+AudioChunk
+FeatureExtractor::getSlicedFeature(const std::vector<cv::Mat> &feature,
+                                   int frameIdx, int featureOffset,
+                                   int numFeatures) {
+  if (numFeatures < 0) {
+    numFeatures = featureOffset + static_cast<int>(feature.size());
   }
 
-  return chunkFeat;
+  const cv::Mat &first = feature.front();
+  if (zeroFeature_.rows != first.rows || zeroFeature_.cols != first.cols) {
+    zeroFeature_ = cv::Mat::zeros(first.rows, first.cols, CV_32F);
+  }
+
+  // Neighbours outside [0, numFeatures) are padded with the zero block
+  AudioChunk chunk;
+  const int left = frameIdx - kSliceWindowSize;
+  for (int i = 0; i < AudioChunk::kNumFeatures; ++i) {
+    const int index = left + i;
+    chunk.features[i] = index < 0 || index >= numFeatures
+                            ? zeroFeature_
+                            : feature[index - featureOffset];
+  }
+  return chunk;
+}
+
+std::vector<AudioChunk>
+FeatureExtractor::convertToChunks(const std::vector<cv::Mat> &featureArray) {
+  std::vector<AudioChunk> audioChunks;
+  audioChunks.reserve(featureArray.size());
+
+  for (int i = 0; i < featureArray.size(); ++i) {
+    audioChunks.push_back(getChunk(featureArray, i));
+  }
+
+  return audioChunks;
 }
 
-cv::Mat FeatureExtractor::getSlicedFeature(const std::vector<cv::Mat> &feature,
-                                           int frameIdx) {
-  const int windowSize = 8;
-  const int left = frameIdx - windowSize;
-  const int right = frameIdx + windowSize;
-  const int padLeft = std::max(0, -left);
-  const int padRight = std::max(0, right - static_cast<int>(feature.size()));
+AudioChunk FeatureExtractor::getChunk(const std::vector<cv::Mat> &featureArray,
+                                      int index) {
+  return getSlicedFeature(featureArray, index);
+}
 
-  const int validLeft = std::max(0, left);
-  const int validRight = std::min(static_cast<int>(feature.size()), right);
+std::vector<AudioChunk>
+FeatureExtractor::acceptWaveform(StreamState &state,
+                                 const std::vector<float> &samples) {
+  if (state.finished) {
+    return {};
+  }
 
-  const int rows = feature[0].rows;
-  const int cols = feature[0].cols;
-  cv::Mat result(rows * 16, cols, CV_32F);
+  fbankComputer_->AcceptWaveform(state.fbankStream, samples.data(),
+                                 samples.size());
+  state.numFbankFrames +=
+      fbankComputer_->PopFrames(state.fbankStream, state.fbankFrames);
 
-  // Fill padding and valid data
-  int currentRow = 0;
+  encodeStreamWindows(state);
+  return popStreamChunks(state);
+}
 
-  // Left padding
-  for (int i = 0; i < padLeft; ++i) {
-    cv::Mat zeroMat = cv::Mat::zeros(rows, cols, CV_32F);
-    zeroMat.copyTo(result(cv::Rect(0, currentRow, cols, rows)));
-    currentRow += rows;
+std::vector<AudioChunk> FeatureExtractor::finishStream(StreamState &state) {
+  if (state.finished) {
+    return {};
   }
+  state.finished = true;
 
-  // Valid data
-  for (int i = validLeft; i < validRight; ++i) {
-    feature[i].copyTo(result(cv::Rect(0, currentRow, cols, rows)));
-    currentRow += rows;
+  // The last frames, if the framing waits for the end of the signal
+  fbankComputer_->InputFinished(state.fbankStream);
+  state.numFbankFrames +=
+      fbankComputer_->PopFrames(state.fbankStream, state.fbankFrames);
+
+  encodeStreamWindows(state);
+  return popStreamChunks(state);
+}
+
+void FeatureExtractor::encodeStreamWindows(StreamState &state) {
+  const int stride = wenetConfig_.framesStride;
+
+  // Complete windows can be encoded as soon as their frames arrive. Once
+  // finished, the remaining windows are zero padded past the last frame
+  auto windowReady = [&]() {
+    return state.windowStart + stride <= state.numFbankFrames ||
+           (state.finished && state.lastWindowEnd < state.numFbankFrames);
+  };
+
+  auto nextWindow = [&]() {
+    state.lastWindowEnd = state.windowStart + stride;
+    state.windowStart += wenetConfig_.slidingStep;
+  };
+
+  if (wenetConfig_.incremental) {
+    while (windowReady() && encodeIncremental(state)) {
+      state.wenetFeatures.push_back(
+          getIncrementalFeature(state, state.windowStart));
+      state.numFeatures++;
+      nextWindow();
+    }
+  } else {
+    // Windows are independent, the ready ones are encoded together so that
+    // they can be batched
+    std::vector<cv::Mat> chunkFeats;
+    auto encodePending = [&]() {
+      if (chunkFeats.empty()) {
+        return;
+      }
+      auto features = windowEncoder_ ? windowEncoder_(chunkFeats)
+                                     : encodeWindows(chunkFeats);
+      if (features.size() != chunkFeats.size()) {
+        throw std::runtime_error("Unexpected number of WeNet features");
+      }
+      for (auto &feature : features) {
+        state.wenetFeatures.push_back(std::move(feature));
+        state.numFeatures++;
+      }
+      chunkFeats.clear();
+    };
+
+    while (windowReady()) {
+      const int start = state.windowStart - state.fbankOffset;
+      chunkFeats.push_back(
+          prepareChunkFeature(state.fbankFrames, start, start + stride));
+      nextWindow();
+      if (chunkFeats.size() >= kMaxPendingWindows) {
+        encodePending();
+      }
+    }
+    encodePending();
   }
 
-  // Right padding
-  for (int i = 0; i < padRight; ++i) {
-    cv::Mat zeroMat = cv::Mat::zeros(rows, cols, CV_32F);
-    zeroMat.copyTo(result(cv::Rect(0, currentRow, cols, rows)));
-    currentRow += rows;
+  // Drop fbank frames before the next window start, or before the next
+  // encoder run in incremental mode
+  const int keepFrom = wenetConfig_.incremental
+                           ? state.nextEncoderRun * kEncoderRunShift
+                           : state.windowStart;
+  const int dim = wenetConfig_.numFeatures;
+  const int drop =
+      std::min(keepFrom - state.fbankOffset,
+               static_cast<int>(state.fbankFrames.size()) / dim);
+  if (drop > 0) {
+    state.fbankFrames.erase(state.fbankFrames.begin(),
+                            state.fbankFrames.begin() + drop * dim);
+    state.fbankOffset += drop;
   }
 
-  return result;
+  // Drop encoder outputs before the next window
+  const int dropBlocks = std::min(
+      state.windowStart / kEncoderSubsampling / kEncoderOutputFrames -
+          state.blockOffset,
+      static_cast<int>(state.encoderBlocks.size()));
+  if (dropBlocks > 0) {
+    state.encoderBlocks.erase(state.encoderBlocks.begin(),
+                              state.encoderBlocks.begin() + dropBlocks);
+    state.blockOffset += dropBlocks;
+  }
 }
 
-std::vector<cv::Mat>
-FeatureExtractor::convertToChunks(const std::vector<cv::Mat> &featureArray) {
-  std::vector<cv::Mat> audioChunks;
-  audioChunks.reserve(featureArray.size());
+std::vector<AudioChunk>
+FeatureExtractor::popStreamChunks(StreamState &state) {
+  std::vector<AudioChunk> chunks;
+
+  // A chunk needs kSliceWindowSize features on its right unless the stream
+  // has finished and the right side is zero padded
+  while (state.nextChunk < state.numFeatures &&
+         (state.finished ||
+          state.nextChunk + kSliceWindowSize <= state.numFeatures)) {
+    chunks.push_back(getSlicedFeature(state.wenetFeatures, state.nextChunk,
+                                      state.featureOffset,
+                                      state.numFeatures));
+    state.nextChunk++;
+  }
 
-  for (int i = 0; i < featureArray.size(); ++i) {
-    audioChunks.push_back(getSlicedFeature(featureArray, i));
+  if (state.keepFeatures) {
+    return chunks;
   }
 
-  return audioChunks;
+  // Drop features no later chunk refers to, the chunks already returned
+  // keep theirs alive
+  const int drop =
+      std::min(state.nextChunk - kSliceWindowSize - state.featureOffset,
+               static_cast<int>(state.wenetFeatures.size()));
+  if (drop > 0) {
+    state.wenetFeatures.erase(state.wenetFeatures.begin(),
+                              state.wenetFeatures.begin() + drop);
+    state.featureOffset += drop;
+  }
+
+  return chunks;
 }
 
 } // namespace lip_sync::infer
@@ -14,6 +14,7 @@
 
 #include "fbank.hpp"
 #include "wenet_encoder.hpp"
+#include <functional>
 #include <memory>
 #include <opencv2/core.hpp>
 #include <vector>
@@ -22,25 +23,158 @@ namespace lip_sync::infer {
 
 class FeatureExtractor {
 public:
+  /**
+   * @brief Carry-over state of an incrementally fed audio stream. Frame,
+   * window and chunk indices are absolute, the buffers only keep what later
+   * steps still need.
+   */
+  struct StreamState {
+    // fbank framing of the preprocessed samples received so far
+    FbankComputer::Stream fbankStream;
+
+    // fbank frames starting at fbankOffset, stored as contiguous rows of
+    // WeNetConfig::numFeatures values
+    std::vector<float> fbankFrames;
+    int fbankOffset = 0;
+    int numFbankFrames = 0;
+
+    // next encoder window start and end of the last encoded window
+    int windowStart = 0;
+    int lastWindowEnd = 0;
+
+    // wenet features starting at featureOffset
+    std::vector<cv::Mat> wenetFeatures;
+    int featureOffset = 0;
+    int numFeatures = 0;
+
+    int nextChunk = 0;
+    bool finished = false;
+
+    // keep every wenet feature, e.g. to cache those of the whole stream,
+    // instead of dropping the ones no later chunk refers to
+    bool keepFeatures = false;
+
+    // incremental encoder: caches and position offset carried between
+    // encoder runs, outputs of each run starting at run blockOffset
+    cv::Mat attCache;
+    cv::Mat cnnCache;
+    int encoderOffset = 0;
+    int nextEncoderRun = 0;
+    std::vector<cv::Mat> encoderBlocks;
+    int blockOffset = 0;
+  };
+
+  /**
+   * @brief Encodes independent windows (framesStride x numFeatures each)
+   * into 16x512 features, one per window and in the same order
+   */
+  using WindowEncoder =
+      std::function<std::vector<cv::Mat>(const std::vector<cv::Mat> &)>;
+
   explicit FeatureExtractor(const FbankConfig &fbankConfig = FbankConfig{},
                             const WeNetConfig &wenetConfig = WeNetConfig{});
   bool initialize();
   std::vector<std::vector<float>> computeFbank(const std::vector<float> &audio);
+
+  /**
+   * @brief Encode one 16x512 feature per slidingStep fbank frames. By default
+   * every window of framesStride frames is encoded on its own with zeroed
+   * caches, up to WeNetConfig::batchSize windows per encoder run. With
+   * WeNetConfig::incremental the encoder runs on consecutive chunks,
+   * carrying its caches, and each window takes the 16 encoder outputs
+   * starting at its first frame, so every fbank frame is encoded once. In a
+   * stream, the incremental mode needs up to one encoder chunk of extra
+   * audio before a window is emitted.
+   */
   std::vector<cv::Mat>
   extractWenetFeatures(const std::vector<std::vector<float>> &fbankFeatures);
-  std::vector<cv::Mat>
+  /**
+   * @brief Audio chunks of all frames, one per feature. The chunks refer to
+   * the features in featureArray and share them with each other.
+   */
+  std::vector<AudioChunk>
   convertToChunks(const std::vector<cv::Mat> &featureArray);
 
+  /**
+   * @brief Build the audio chunk of a single frame, equal to
+   * convertToChunks(featureArray)[index]
+   */
+  AudioChunk getChunk(const std::vector<cv::Mat> &featureArray, int index);
+
+  /**
+   * @brief Feed preprocessed samples of a stream and return the audio chunks
+   * that became complete. The concatenation of all returned chunks equals
+   * convertToChunks(extractWenetFeatures(computeFbank(all samples))).
+   */
+  std::vector<AudioChunk> acceptWaveform(StreamState &state,
+                                         const std::vector<float> &samples);
+
+  /**
+   * @brief Mark the stream as finished and return the remaining chunks
+   */
+  std::vector<AudioChunk> finishStream(StreamState &state);
+
+  /**
+   * @brief Encode independent windows with this extractor's encoder,
+   * stacking up to WeNetConfig::batchSize of them into one run when the
+   * model has a dynamic batch dimension. Silent windows take the cached
+   * silence features, shared between them, without running the encoder.
+   */
+  std::vector<cv::Mat> encodeWindows(const std::vector<cv::Mat> &chunkFeats);
+
+  /**
+   * @brief Hand windowed encoding to another encoder, e.g. one shared by
+   * several extractors so that their windows are batched together. Set
+   * before initialize(), which then skips loading the encoder unless the
+   * incremental mode needs it.
+   */
+  void setWindowEncoder(WindowEncoder encoder);
+
 private:
-  cv::Mat getSlicedFeature(const std::vector<cv::Mat> &feature, int frameIdx);
-  cv::Mat
-  prepareChunkFeature(const std::vector<std::vector<float>> &fbankFeatures,
-                      int start, int end);
+  AudioChunk getSlicedFeature(const std::vector<cv::Mat> &feature,
+                              int frameIdx, int featureOffset = 0,
+                              int numFeatures = -1);
+  cv::Mat prepareChunkFeature(const std::vector<float> &fbankFrames,
+                              int start, int end);
+  cv::Mat encodeChunk(const cv::Mat &chunkFeat);
+  bool initSilenceCache();
+  bool isSilentWindow(const cv::Mat &chunkFeat) const;
+  /**
+   * @brief Run the encoder once. The output stays valid until the next run.
+   */
+  const WeNetEncoderOutput &runEncoder(const cv::Mat &chunkFeat, int offset,
+                                       const cv::Mat &attCache,
+                                       const cv::Mat &cnnCache,
+                                       int batchSize = 1);
+
+  /**
+   * @brief Run the encoder until the outputs of the window at
+   * state.windowStart are available. Returns false if that needs fbank
+   * frames that have not arrived yet.
+   */
+  bool encodeIncremental(StreamState &state);
+  cv::Mat getIncrementalFeature(const StreamState &state, int windowStart);
+
+  void encodeStreamWindows(StreamState &state);
+  std::vector<AudioChunk> popStreamChunks(StreamState &state);
 
   FbankConfig fbankConfig_;
   WeNetConfig wenetConfig_;
   std::unique_ptr<FbankComputer> fbankComputer_;
   std::unique_ptr<dnn::WeNetEncoderInference> wenetEncoder_;
+  WindowEncoder windowEncoder_;
+  // Packed batch input and outputs of the encoder, reused by every run
+  cv::Mat encoderBatch_;
+  AlgoOutput encoderOutput_;
+  int batchSize_ = 1;
+  cv::Mat attCache_;
+  cv::Mat cnnCache_;
+  // Padding of the chunks at the clip edges, shared by all of them
+  cv::Mat zeroFeature_;
+  // Fbank frame of digital silence and the encoder output of a window of
+  // them, empty when the cache is disabled
+  std::vector<float> silenceFrame_;
+  cv::Mat silenceFeature_;
 };
 } // namespace lip_sync::infer
 
@@ -0,0 +1,261 @@
+/**
+ * @file feature_file.cpp
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Binary file of precomputed encoder features
+ * @version 0.1
+ * @date 2025-01-09
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "feature_file.hpp"
+#include "logger/logger.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <process.h>
+#endif
+
+namespace lip_sync::infer {
+
+namespace {
+
+constexpr char kMagic[4] = {'L', 'S', 'F', 'F'};
+constexpr uint64_t kAlignment = 64;
+
+struct FileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t headerSize;
+  uint32_t sampleRate;
+  uint64_t key;
+  uint64_t modelKey;
+  uint32_t numFeatures;
+  uint32_t rows;
+  uint32_t cols;
+  uint32_t reserved;
+  uint64_t audioOffset;
+  uint64_t numSamples;
+};
+static_assert(sizeof(FileHeader) == kAlignment, "Unexpected header size");
+
+long processId() {
+#ifdef _WIN32
+  return _getpid();
+#else
+  return ::getpid();
+#endif
+}
+
+uint64_t alignUp(uint64_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+uint64_t featureBytes(const FileHeader &header) {
+  return static_cast<uint64_t>(header.numFeatures) * header.rows *
+         header.cols * sizeof(float);
+}
+
+// Header fields against the file size, nothing is read past the end. Each
+// field is bounded by the bytes left for it before any product is taken, so
+// a corrupt header cannot wrap the sizes
+bool validHeader(const FileHeader &header, uint64_t fileSize) {
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != FeatureFile::kVersion ||
+      header.headerSize < sizeof(FileHeader) ||
+      header.headerSize % kAlignment != 0 ||
+      header.headerSize > header.audioOffset ||
+      header.audioOffset > fileSize ||
+      header.numSamples > (fileSize - header.audioOffset) / sizeof(float)) {
+    return false;
+  }
+  if (header.numFeatures == 0) {
+    return true;
+  }
+  if (header.rows == 0 || header.cols == 0) {
+    return false;
+  }
+  const uint64_t featureSize = static_cast<uint64_t>(header.rows) * header.cols;
+  const uint64_t available =
+      (header.audioOffset - header.headerSize) / sizeof(float);
+  // The features are loaded as one matrix of int rows
+  return header.numFeatures <= available / featureSize &&
+         static_cast<uint64_t>(header.numFeatures) * header.rows <=
+             static_cast<uint64_t>(std::numeric_limits<int>::max());
+}
+
+} // namespace
+
+bool FeatureFile::write(const std::string &path,
+                        const std::vector<cv::Mat> &features,
+                        const std::vector<float> &audio, uint64_t key,
+                        uint64_t modelKey, uint32_t sampleRate) {
+  FileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.headerSize = sizeof(FileHeader);
+  header.sampleRate = sampleRate;
+  header.key = key;
+  header.modelKey = modelKey;
+  header.numFeatures = static_cast<uint32_t>(features.size());
+  if (!features.empty()) {
+    header.rows = static_cast<uint32_t>(features.front().rows);
+    header.cols = static_cast<uint32_t>(features.front().cols);
+  }
+  for (const auto &feature : features) {
+    if (feature.type() != CV_32F ||
+        static_cast<uint32_t>(feature.rows) != header.rows ||
+        static_cast<uint32_t>(feature.cols) != header.cols) {
+      LOGGER_ERROR("Features of {} differ in shape or type", path);
+      return false;
+    }
+  }
+  header.audioOffset = alignUp(header.headerSize + featureBytes(header));
+  header.numSamples = audio.size();
+
+  std::error_code error;
+  const auto parent = std::filesystem::path(path).parent_path();
+  if (!parent.empty()) {
+    std::filesystem::create_directories(parent, error);
+  }
+
+  // Written under a name of its own and renamed, readers and concurrent
+  // writers of the same path, in any process, never see a partial file
+  const std::string tmpPath =
+      path + "." + std::to_string(processId()) + "." +
+      std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) +
+      ".tmp";
+  {
+    std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const auto &feature : features) {
+      cv::Mat continuous = feature.isContinuous() ? feature : feature.clone();
+      file.write(reinterpret_cast<const char *>(continuous.data),
+                 continuous.total() * continuous.elemSize());
+    }
+    const std::vector<char> padding(
+        header.audioOffset - header.headerSize - featureBytes(header), 0);
+    file.write(padding.data(), padding.size());
+    file.write(reinterpret_cast<const char *>(audio.data()),
+               audio.size() * sizeof(float));
+    if (!file) {
+      LOGGER_ERROR("Failed to write feature file {}", tmpPath);
+      file.close();
+      std::filesystem::remove(tmpPath, error);
+      return false;
+    }
+  }
+  std::filesystem::rename(tmpPath, path, error);
+  if (error) {
+    LOGGER_ERROR("Failed to write feature file {}: {}", path,
+                 error.message());
+    std::filesystem::remove(tmpPath, error);
+    return false;
+  }
+  return true;
+}
+
+std::shared_ptr<const FeatureFile> FeatureFile::open(const std::string &path,
+                                                     bool map) {
+  std::shared_ptr<FeatureFile> result(new FeatureFile());
+  FileHeader header;
+  const uint8_t *base = nullptr;
+
+#ifndef _WIN32
+  if (map) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return nullptr;
+    }
+    struct stat st;
+    void *mapping = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 &&
+        static_cast<uint64_t>(st.st_size) >= sizeof(FileHeader)) {
+      mapping = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+      LOGGER_ERROR("Failed to map feature file {}", path);
+      return nullptr;
+    }
+    result->mapping_ = mapping;
+    result->mappingSize_ = st.st_size;
+    base = static_cast<const uint8_t *>(mapping);
+    std::memcpy(&header, base, sizeof(header));
+    if (!validHeader(header, st.st_size)) {
+      LOGGER_ERROR("Invalid feature file {}", path);
+      return nullptr;
+    }
+  }
+#endif
+
+  if (!base) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+      return nullptr;
+    }
+    const uint64_t fileSize = file.tellg();
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        !validHeader(header, fileSize)) {
+      LOGGER_ERROR("Invalid feature file {}", path);
+      return nullptr;
+    }
+
+    // One allocation for the features, each one is a view of its rows
+    cv::Mat data(header.numFeatures * header.rows, header.cols, CV_32F);
+    result->audioData_.resize(header.numSamples);
+    file.seekg(header.headerSize);
+    file.read(reinterpret_cast<char *>(data.data), featureBytes(header));
+    file.seekg(header.audioOffset);
+    file.read(reinterpret_cast<char *>(result->audioData_.data()),
+              header.numSamples * sizeof(float));
+    if (!file) {
+      LOGGER_ERROR("Failed to read feature file {}", path);
+      return nullptr;
+    }
+    for (uint32_t i = 0; i < header.numFeatures; ++i) {
+      result->features_.push_back(
+          data.rowRange(i * header.rows, (i + 1) * header.rows));
+    }
+    result->audio_ = result->audioData_.data();
+  } else {
+    // The mapping is read only, the features are never written to
+    auto *features =
+        const_cast<float *>(reinterpret_cast<const float *>(
+            base + header.headerSize));
+    const size_t featureSize = static_cast<size_t>(header.rows) * header.cols;
+    for (uint32_t i = 0; i < header.numFeatures; ++i) {
+      result->features_.push_back(cv::Mat(header.rows, header.cols, CV_32F,
+                                          features + i * featureSize));
+    }
+    result->audio_ =
+        reinterpret_cast<const float *>(base + header.audioOffset);
+  }
+
+  result->numSamples_ = header.numSamples;
+  result->sampleRate_ = header.sampleRate;
+  result->key_ = header.key;
+  result->modelKey_ = header.modelKey;
+  return result;
+}
+
+FeatureFile::~FeatureFile() {
+#ifndef _WIN32
+  if (mapping_) {
+    ::munmap(mapping_, mappingSize_);
+  }
+#endif
+}
+
+} // namespace lip_sync::infer
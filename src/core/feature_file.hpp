@@ -0,0 +1,86 @@
+/**
+ * @file feature_file.hpp
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Binary file of precomputed encoder features
+ * @version 0.1
+ * @date 2025-01-09
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __LIP_SYNC_FEATURE_FILE_HPP_
+#define __LIP_SYNC_FEATURE_FILE_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+
+namespace lip_sync::infer {
+
+/**
+ * @brief Encoder features of a clip, optionally with its audio, in a
+ * versioned binary file laid out to be memory mapped.
+ *
+ * Layout, little endian:
+ *   0   64 byte header: magic "LSFF", version, header size, sample rate,
+ *       content key, model key, feature count, rows, cols, audio offset and
+ *       sample count
+ *   64  feature count row-major float matrices of rows x cols
+ *   ... samples as floats at the audio offset, a multiple of 64
+ *
+ * A mapped file hands out features that are views of the mapping and stay
+ * valid while the FeatureFile lives. A loaded one owns its data.
+ */
+class FeatureFile {
+public:
+  static constexpr uint32_t kVersion = 1;
+
+  /**
+   * @brief Write features and audio to path, replacing the file atomically
+   * @param key content key of the clip, 0 if unknown
+   * @param modelKey identity of the encoder that computed the features
+   */
+  static bool write(const std::string &path,
+                    const std::vector<cv::Mat> &features,
+                    const std::vector<float> &audio, uint64_t key = 0,
+                    uint64_t modelKey = 0, uint32_t sampleRate = 16000);
+
+  /**
+   * @brief Open a feature file, mapping it where supported unless map is
+   * false. nullptr if it is missing, truncated or of another version.
+   */
+  static std::shared_ptr<const FeatureFile> open(const std::string &path,
+                                                 bool map = true);
+
+  ~FeatureFile();
+  FeatureFile(const FeatureFile &) = delete;
+  FeatureFile &operator=(const FeatureFile &) = delete;
+
+  const std::vector<cv::Mat> &features() const { return features_; }
+  const float *audio() const { return audio_; }
+  size_t numSamples() const { return numSamples_; }
+  uint32_t sampleRate() const { return sampleRate_; }
+  uint64_t key() const { return key_; }
+  uint64_t modelKey() const { return modelKey_; }
+
+private:
+  FeatureFile() = default;
+
+  std::vector<cv::Mat> features_;
+  const float *audio_ = nullptr;
+  size_t numSamples_ = 0;
+  uint32_t sampleRate_ = 0;
+  uint64_t key_ = 0;
+  uint64_t modelKey_ = 0;
+
+  // Mapping of the file, or the audio of a loaded one
+  void *mapping_ = nullptr;
+  size_t mappingSize_ = 0;
+  std::vector<float> audioData_;
+};
+} // namespace lip_sync::infer
+
+#endif
@@ -0,0 +1,181 @@
+/**
+ * @file model_registry.cpp
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Process wide registry of ONNX Runtime sessions
+ * @version 0.1
+ * @date 2025-01-10
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "model_registry.hpp"
+#include "logger/logger.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+namespace lip_sync::infer::dnn {
+
+namespace {
+
+// Settings that give a session of its own, appended to the model path
+std::string sessionKey(const std::string &path, const SessionConfig &config,
+                       int replica) {
+  char suffix[96];
+  std::snprintf(suffix, sizeof(suffix), "|%d|%d|%d%d%d%d%d|%d",
+                config.intraOpThreads, config.interOpThreads,
+                config.parallelExecution, config.allowSpinning,
+                config.memPattern, config.cpuMemArena,
+                config.globalThreadPool, replica);
+  return path + suffix;
+}
+
+Ort::SessionOptions sessionOptions(const SessionConfig &config) {
+  Ort::SessionOptions options;
+  options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+  options.SetExecutionMode(config.parallelExecution
+                               ? ExecutionMode::ORT_PARALLEL
+                               : ExecutionMode::ORT_SEQUENTIAL);
+  if (config.globalThreadPool) {
+    options.DisablePerSessionThreads();
+  } else {
+    options.SetIntraOpNumThreads(std::max(config.intraOpThreads, 1));
+    options.SetInterOpNumThreads(std::max(config.interOpThreads, 1));
+    const char *spinning = config.allowSpinning ? "1" : "0";
+    options.AddConfigEntry("session.intra_op.allow_spinning", spinning);
+    options.AddConfigEntry("session.inter_op.allow_spinning", spinning);
+  }
+  if (config.memPattern) {
+    options.EnableMemPattern();
+  } else {
+    options.DisableMemPattern();
+  }
+  if (config.cpuMemArena) {
+    options.EnableCpuMemArena();
+  } else {
+    options.DisableCpuMemArena();
+  }
+  return options;
+}
+
+} // namespace
+
+ModelRegistry &ModelRegistry::instance() {
+  static ModelRegistry registry;
+  return registry;
+}
+
+void ModelRegistry::createResources(bool globalThreadPool) {
+  auto resources = std::make_shared<Resources>();
+  if (globalThreadPool) {
+    Ort::ThreadingOptions threading;
+    threading.SetGlobalIntraOpNumThreads(threadPool_.intraOpThreads);
+    threading.SetGlobalInterOpNumThreads(threadPool_.interOpThreads);
+    threading.SetGlobalSpinControl(threadPool_.allowSpinning ? 1 : 0);
+    resources->env = std::make_unique<Ort::Env>(
+        threading, ORT_LOGGING_LEVEL_WARNING, "lip_sync");
+    LOGGER_INFO("Global thread pool of {} intra-op and {} inter-op threads",
+                threadPool_.intraOpThreads, threadPool_.interOpThreads);
+  } else {
+    resources->env =
+        std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "lip_sync");
+  }
+  resources->globalThreadPool = globalThreadPool;
+  resources_ = std::move(resources);
+}
+
+bool ModelRegistry::setGlobalThreadPool(const ThreadPoolConfig &config) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const bool same = threadPoolSet_ &&
+                    config.intraOpThreads == threadPool_.intraOpThreads &&
+                    config.interOpThreads == threadPool_.interOpThreads &&
+                    config.allowSpinning == threadPool_.allowSpinning;
+  if (resources_) {
+    if (!resources_->globalThreadPool || !same) {
+      LOGGER_WARN("Models are already loaded, global thread pool unchanged");
+      return false;
+    }
+    return true;
+  }
+  threadPool_ = config;
+  threadPoolSet_ = true;
+  return true;
+}
+
+std::shared_ptr<Ort::Session>
+ModelRegistry::acquire(const std::string &modelPath,
+                       const SessionConfig &config, int replica) {
+  // The same file given by different paths is loaded once
+  std::error_code error;
+  const std::filesystem::path path(modelPath);
+  auto canonical = std::filesystem::weakly_canonical(path, error);
+
+  // Held while loading, concurrent requests for a model wait for it
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // The Env holds the only global pool there can be, a session asking for
+  // it after the Env was created without one gets a pool of its own
+  SessionConfig effective = config;
+  if (config.globalThreadPool && resources_ &&
+      !resources_->globalThreadPool) {
+    LOGGER_ERROR("Model {} asks for the global thread pool, but models "
+                 "without it were loaded first, using a pool of its own",
+                 modelPath);
+    effective.globalThreadPool = false;
+  }
+  const std::string key =
+      sessionKey(error ? modelPath : canonical.string(), effective, replica);
+
+  // Entries of released sessions are dropped, the map only holds few
+  for (auto iter = sessions_.begin(); iter != sessions_.end();) {
+    if (iter->second.expired()) {
+      iter = sessions_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+  auto iter = sessions_.find(key);
+  if (iter != sessions_.end()) {
+    if (auto session = iter->second.lock()) {
+      return session;
+    }
+  }
+
+  try {
+    // The Env, and with it the global pool, is created once
+    if (!resources_) {
+      createResources(threadPoolSet_ || effective.globalThreadPool);
+    }
+
+    // A path is wide on Windows, the native string matches ORTCHAR_T
+    auto resources = resources_;
+    std::shared_ptr<Ort::Session> session(
+        new Ort::Session(*resources->env, path.c_str(),
+                         sessionOptions(effective),
+                         resources->prepackedWeights),
+        [resources](Ort::Session *session) { delete session; });
+
+    sessions_[key] = session;
+    LOGGER_INFO("Loaded model {}, replica {}, {} intra-op threads{}",
+                modelPath, replica, effective.intraOpThreads,
+                effective.globalThreadPool ? " of the global pool" : "");
+    return session;
+  } catch (const Ort::Exception &e) {
+    LOGGER_ERROR("ONNX Runtime error loading model {}: {}", modelPath,
+                 e.what());
+    return nullptr;
+  }
+}
+
+size_t ModelRegistry::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t count = 0;
+  for (const auto &entry : sessions_) {
+    if (!entry.second.expired()) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+} // namespace lip_sync::infer::dnn
@@ -0,0 +1,95 @@
+/**
+ * @file model_registry.hpp
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Process wide registry of ONNX Runtime sessions
+ * @version 0.1
+ * @date 2025-01-10
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __LIP_SYNC_MODEL_REGISTRY_HPP_
+#define __LIP_SYNC_MODEL_REGISTRY_HPP_
+
+#include "types.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <onnxruntime_cxx_api.h>
+#include <string>
+
+namespace lip_sync::infer::dnn {
+
+/**
+ * @brief Sessions of the process, one per model file, settings and replica
+ * index, created in a single Ort::Env and sharing one prepacked weights
+ * container. Sessions run concurrently, so every inference object of a
+ * model, in any worker or SDK instance, holds a handle to the same session
+ * and only keeps its own input and output bindings. Replicas of a model
+ * share its prepacked weights and run on thread pools of their own. A
+ * session is released with its last handle. Thread safe.
+ */
+class ModelRegistry {
+public:
+  /**
+   * @brief Threads of the process wide pool, 0 for the ORT default of one
+   * per core
+   */
+  struct ThreadPoolConfig {
+    int intraOpThreads = 0;
+    int interOpThreads = 0;
+    bool allowSpinning = true;
+  };
+
+  static ModelRegistry &instance();
+
+  /**
+   * @brief Create the Env with a process wide thread pool, shared by the
+   * sessions of SessionConfig::globalThreadPool. Only possible before the
+   * first session is loaded, false if the Env exists with other settings.
+   * Without it the pool takes the default settings when the first session
+   * asks for it.
+   */
+  bool setGlobalThreadPool(const ThreadPoolConfig &config);
+
+  /**
+   * @brief Session of a model file, loaded on the first request. nullptr if
+   * it fails to load. Asking for the global pool after models without it
+   * created the Env logs an error and gives the session a pool of its own,
+   * shared with the requests of the same settings without the global pool.
+   */
+  std::shared_ptr<Ort::Session> acquire(const std::string &modelPath,
+                                        const SessionConfig &config = {},
+                                        int replica = 0);
+
+  /**
+   * @brief Number of sessions currently loaded
+   */
+  size_t size() const;
+
+  ModelRegistry(const ModelRegistry &) = delete;
+  ModelRegistry &operator=(const ModelRegistry &) = delete;
+
+private:
+  ModelRegistry() = default;
+
+  // Shared by the sessions, each of which keeps them alive through its
+  // deleter, so that they outlive the registry at exit
+  struct Resources {
+    std::unique_ptr<Ort::Env> env;
+    bool globalThreadPool = false;
+    Ort::PrepackedWeightsContainer prepackedWeights;
+  };
+
+  void createResources(bool globalThreadPool);
+
+  mutable std::mutex mutex_;
+  std::shared_ptr<Resources> resources_;
+  ThreadPoolConfig threadPool_;
+  bool threadPoolSet_ = false;
+  std::map<std::string, std::weak_ptr<Ort::Session>> sessions_;
+};
+} // namespace lip_sync::infer::dnn
+
+#endif
@@ -12,6 +12,7 @@
 #ifndef __INFERENCE_TYPES_H__
 #define __INFERENCE_TYPES_H__
 
+#include <array>
 #include <memory>
 #include <opencv2/opencv.hpp>
 #include <string>
@@ -96,9 +97,31 @@ private:
   Params params_;
 };
 
+/**
+ * @brief ONNX Runtime session settings of a model
+ */
+struct SessionConfig {
+  // Threads of a single run, within and across operators. The inter-op
+  // threads only serve the parallel execution mode.
+  int intraOpThreads = 1;
+  int interOpThreads = 1;
+  bool parallelExecution = false;
+  // Idle pool threads spin before sleeping, lower latency for more CPU
+  bool allowSpinning = true;
+  bool memPattern = true;
+  bool cpuMemArena = true;
+  // Run on the process wide pool of the model registry instead of threads
+  // of the session's own, the thread counts above are then ignored
+  bool globalThreadPool = false;
+};
+
 struct AlgoBase {
   std::string name;
   std::string modelPath;
+  SessionConfig session;
+  // Models of the same file and settings share a session, those with
+  // another replica index get a session of their own
+  int replica = 0;
 };
 
 struct ProcessedFaceData {
@@ -124,19 +147,64 @@ struct WeNetConfig {
   int numFeatures = 80;
   int slidingStep = 5;
   std::string modelPath;
+  // Encode each fbank frame once, carrying the attention and conv caches
+  // between encoder runs, instead of re-encoding overlapping windows
+  bool incremental = false;
+  // Reuse the encoder output of a silent window, computed once at
+  // initialization, for windows whose fbank frames all match those of
+  // digital silence within silenceTolerance. Zero and constant input give
+  // exactly the silent frames, so the default tolerance only takes those.
+  bool silenceCache = true;
+  float silenceTolerance = 0.0f;
+  // Session of the encoder model, see AlgoBase
+  SessionConfig session;
+  int replica = 0;
+};
+
+/**
+ * @brief Audio input of one frame: the encoder features around it, referenced
+ * rather than copied. Neighbours past the clip edges share one zero block, so
+ * a chunk costs a few Mat headers and the features are stored once. The
+ * features are gathered into the [16 * 16, 512] model input at inference.
+ */
+struct AudioChunk {
+  static constexpr int kNumFeatures = 16;
+  // Shape of one encoder feature
+  static constexpr int kFeatureRows = 16;
+  static constexpr int kFeatureCols = 512;
+  std::array<cv::Mat, kNumFeatures> features;
+
+  bool empty() const { return features[0].empty(); }
+  int rows() const { return kNumFeatures * features[0].rows; }
+  int cols() const { return features[0].cols; }
+  size_t total() const { return kNumFeatures * features[0].total(); }
+
+  // Gather into total() contiguous floats
+  void copyTo(float *dst) const {
+    for (const auto &feature : features) {
+      feature.copyTo(cv::Mat(feature.rows, feature.cols, CV_32F, dst));
+      dst += feature.total();
+    }
+  }
+
+  cv::Mat toMat() const {
+    cv::Mat result(rows(), cols(), CV_32F);
+    copyTo(result.ptr<float>());
+    return result;
+  }
 };
 
 struct ProcessUnit {
   std::string uuid;
   int64_t sequence;
 
-  cv::Mat audioChunk;
+  AudioChunk audioChunk;
   ProcessedFaceData faceData;
 
   std::shared_ptr<cv::Mat> originImage;
+  cv::Rect faceBox;
 
   int64_t timestamp;
-  std::vector<float> audioSegment;
 
   bool isLastChunk{false};
 };
@@ -29,79 +29,49 @@ bool WavToLipInference::infer(AlgoInput &input, AlgoOutput &output) {
   }
 
   try {
-    // Prepare input tensors
-    inputTensors.clear();
-
     // Process image data
-    if (wavToLipInput->image.empty() || wavToLipInput->image.type() != CV_32F) {
+    const cv::Mat &image = wavToLipInput->image;
+    if (image.empty() || image.type() != CV_32F || !image.isContinuous()) {
       LOGGER_ERROR("Invalid image data");
       return false;
     }
 
-    // Create shape vectors for actual inference
-    std::vector<int64_t> imageShape = inputShape[0]; // Copy the original shape
-    if (imageShape[0] == -1) { // Replace dynamic batch size with 1
-      imageShape[0] = 1;
+    // Batch size comes from the leading dim of a packed NCHW image
+    const int64_t batchSize = image.dims == 4 ? image.size[0] : 1;
+
+    // Shapes of the actual inference, reusing the members' storage
+    imageShape = inputShape[0];
+    if (imageShape[0] == -1) { // Replace dynamic batch size
+      imageShape[0] = batchSize;
+    } else if (imageShape[0] != batchSize) {
+      LOGGER_ERROR("Model batch size is fixed to {}, got {}", imageShape[0],
+                   batchSize);
+      return false;
     }
     LOGGER_DEBUG("Actual image tensor shape: {}x{}x{}x{}", imageShape[0],
                  imageShape[1], imageShape[2], imageShape[3]);
 
-    std::vector<int64_t> audioShape = inputShape[1]; // Copy the original shape
-    if (audioShape[0] == -1) { // Replace dynamic batch size with 1
-      audioShape[0] = 1;
+    audioShape = inputShape[1];
+    if (audioShape[0] == -1) { // Replace dynamic batch size
+      audioShape[0] = batchSize;
     }
     LOGGER_DEBUG("Actual audio tensor shape: {}x{}x{}x{}", audioShape[0],
                  audioShape[1], audioShape[2], audioShape[3]);
 
-    // Create input tensors with corrected shapes
-    inputTensors.emplace_back(Ort::Value::CreateTensor<float>(
-        *memoryInfo, (float *)wavToLipInput->image.data,
-        wavToLipInput->image.total() * wavToLipInput->image.channels(),
-        imageShape.data(), imageShape.size()));
-
     // Process audio feature data
-    if (wavToLipInput->audioFeature.empty() ||
-        wavToLipInput->audioFeature.type() != CV_32F) {
+    const cv::Mat &audioFeature = wavToLipInput->audioFeature;
+    if (audioFeature.empty() || audioFeature.type() != CV_32F ||
+        !audioFeature.isContinuous()) {
       LOGGER_ERROR("Invalid audio feature data");
       return false;
     }
 
-    inputTensors.emplace_back(Ort::Value::CreateTensor<float>(
-        *memoryInfo, (float *)wavToLipInput->audioFeature.data,
-        wavToLipInput->audioFeature.total(), audioShape.data(),
-        audioShape.size()));
-
-    LOGGER_DEBUG("Number of input tensors created: {}", inputTensors.size());
-
-    // Convert input/output names to const char* array
-    std::vector<const char *> inputNamesPtr;
-    std::vector<const char *> outputNamesPtr;
-
-    for (const auto &name : inputNames) {
-      inputNamesPtr.push_back(name.c_str());
-    }
-    for (const auto &name : outputNames) {
-      outputNamesPtr.push_back(name.c_str());
-    }
-
-    // Run inference
-    outputTensors = session->Run(Ort::RunOptions{nullptr}, inputNamesPtr.data(),
-                                 inputTensors.data(), inputTensors.size(),
-                                 outputNamesPtr.data(), outputNamesPtr.size());
-
-    // Process output tensors
-    if (outputTensors.empty()) {
-      LOGGER_ERROR("No output tensors produced");
-      return false;
-    }
-
-    // Get output data
-    float *outData = outputTensors[0].GetTensorMutableData<float>();
-    size_t outSize =
-        outputTensors[0].GetTensorTypeAndShapeInfo().GetElementCount();
-
-    // Assign output data to mel vector
-    wavToLipOutput->mel.assign(outData, outData + outSize);
+    // Inputs are bound in place, the mel is written to the caller's buffer
+    bindInput(0, image.ptr<float>(), image.total() * image.channels(),
+              imageShape.data(), imageShape.size());
+    bindInput(1, audioFeature.ptr<float>(), audioFeature.total(),
+              audioShape.data(), audioShape.size());
+    runBinding({&wavToLipOutput->mel});
 
     LOGGER_DEBUG("Output mel size: {}", wavToLipOutput->mel.size());
 
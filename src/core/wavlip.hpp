@@ -19,6 +19,20 @@ public:
   explicit WavToLipInference(const AlgoBase &param) : AlgoInference(param) {}
 
   bool infer(AlgoInput &input, AlgoOutput &output) override;
+
+  /**
+   * @brief Whether the model accepts a packed batch of frames, i.e. the
+   * image input has a dynamic batch dimension
+   */
+  bool supportsBatch() const {
+    return !inputShape.empty() && !inputShape[0].empty() &&
+           inputShape[0][0] == -1;
+  }
+
+private:
+  // Input shapes of the current run
+  std::vector<int64_t> imageShape;
+  std::vector<int64_t> audioShape;
 };
 } // namespace lip_sync::infer::dnn
 #endif
@@ -26,37 +26,23 @@ bool WeNetEncoderInference::infer(AlgoInput &input, AlgoOutput &output) {
   }
 
   try {
-    // Prepare input tensors
-    std::vector<float> chunkData;
-    cv::Mat chunk = encoderInput->chunk;
-    if (chunk.empty() || chunk.type() != CV_32F) {
+    // Inputs are bound in place, without copying them
+    const cv::Mat &chunk = encoderInput->chunk;
+    if (chunk.empty() || chunk.type() != CV_32F || !chunk.isContinuous()) {
       LOGGER_ERROR("Invalid chunk data");
       return false;
     }
+    LOGGER_DEBUG("Chunk data size: {}", chunk.total());
 
-    // Convert Mat to float vector using total() for all dimensions
-    chunkData.assign((float *)chunk.data, (float *)chunk.data + chunk.total());
-
-    LOGGER_DEBUG("Chunk data size: {}", chunkData.size());
-
-    std::vector<float> attCacheData;
-    cv::Mat attCache = encoderInput->attCache;
-    if (!attCache.empty()) {
-      attCacheData.assign((float *)attCache.data,
-                          (float *)attCache.data + attCache.total());
-    }
-    LOGGER_DEBUG("AttCache data size: {}", attCacheData.size());
-
-    std::vector<float> cnnCacheData;
-    cv::Mat cnnCache = encoderInput->cnnCache;
-    if (!cnnCache.empty()) {
-      cnnCacheData.assign((float *)cnnCache.data,
-                          (float *)cnnCache.data + cnnCache.total());
+    const cv::Mat &attCache = encoderInput->attCache;
+    const cv::Mat &cnnCache = encoderInput->cnnCache;
+    if (attCache.empty() || cnnCache.empty() || !attCache.isContinuous() ||
+        !cnnCache.isContinuous()) {
+      LOGGER_ERROR("Invalid cache data");
+      return false;
     }
-    LOGGER_DEBUG("CNNCache data size: {}", cnnCacheData.size());
-
-    // Create input tensors
-    inputTensors.clear();
+    LOGGER_DEBUG("AttCache data size: {}", attCache.total());
+    LOGGER_DEBUG("CNNCache data size: {}", cnnCache.total());
 
     // Print shape information for debugging
     LOGGER_DEBUG("Input shape 0 size: {}", inputShape[0].size());
@@ -64,73 +50,43 @@ bool WeNetEncoderInference::infer(AlgoInput &input, AlgoOutput &output) {
       LOGGER_DEBUG("Input shape 0[{}]: {}", i, inputShape[0][i]);
     }
 
-    // Add chunk tensor
-    inputTensors.emplace_back(Ort::Value::CreateTensor<float>(
-        *memoryInfo, chunkData.data(), chunkData.size(), inputShape[0].data(),
-        inputShape[0].size()));
-
-    // Add offset tensor
-    std::vector<int64_t> offsetData = {encoderInput->offset};
-    inputTensors.emplace_back(Ort::Value::CreateTensor<int64_t>(
-        *memoryInfo, offsetData.data(), offsetData.size(), inputShape[1].data(),
-        inputShape[1].size()));
-
-    // Add att_cache tensor if present
-    if (!attCacheData.empty()) {
-      inputTensors.emplace_back(Ort::Value::CreateTensor<float>(
-          *memoryInfo, attCacheData.data(), attCacheData.size(),
-          inputShape[2].data(), inputShape[2].size()));
+    // Batch size comes from the leading dim of a packed [K, T, F] chunk
+    const int64_t batchSize = chunk.dims == 3 ? chunk.size[0] : 1;
+    chunkShape = inputShape[0];
+    if (chunkShape[0] == -1) { // Replace dynamic batch size
+      chunkShape[0] = batchSize;
+    } else if (chunkShape[0] != batchSize) {
+      LOGGER_ERROR("Model batch size is fixed to {}, got {}", chunkShape[0],
+                   batchSize);
+      return false;
     }
-
-    // Add cnn_cache tensor if present
-    if (!cnnCacheData.empty()) {
-      inputTensors.emplace_back(Ort::Value::CreateTensor<float>(
-          *memoryInfo, cnnCacheData.data(), cnnCacheData.size(),
-          inputShape[3].data(), inputShape[3].size()));
+    if (batchSize > 1 && !supportsBatch()) {
+      LOGGER_ERROR("Model caches have dynamic shapes, batch of {} windows "
+                   "not supported",
+                   batchSize);
+      return false;
     }
 
-    LOGGER_DEBUG("Number of input tensors created: {}", inputTensors.size());
+    bindInput(0, chunk.ptr<float>(), chunk.total(), chunkShape.data(),
+              chunkShape.size());
 
-    // Convert input/output names to const char* array
-    std::vector<const char *> input_names_ptr;
-    std::vector<const char *> output_names_ptr;
-
-    for (const auto &name : inputNames) {
-      input_names_ptr.push_back(name.c_str());
-    }
-    for (const auto &name : outputNames) {
-      output_names_ptr.push_back(name.c_str());
-    }
+    // The offset lives in a member, it is bound once
+    offsetData = encoderInput->offset;
+    bindInput(1, &offsetData, 1, inputShape[1].data(), inputShape[1].size());
 
-    // Run inference
-    outputTensors = session->Run(
-        Ort::RunOptions{nullptr}, input_names_ptr.data(), inputTensors.data(),
-        inputTensors.size(), output_names_ptr.data(), output_names_ptr.size());
+    bindInput(2, attCache.ptr<float>(), attCache.total(),
+              inputShape[2].data(), inputShape[2].size());
+    bindInput(3, cnnCache.ptr<float>(), cnnCache.total(),
+              inputShape[3].data(), inputShape[3].size());
 
-    // Process output tensors
-    if (outputTensors.size() != 3) {
+    // Outputs are written to the caller's buffers
+    if (outputNames.size() != 3) {
       LOGGER_ERROR("Unexpected number of output tensors: {}",
-                   outputTensors.size());
+                   outputNames.size());
       return false;
     }
-
-    // Get output data
-    float *outData = outputTensors[0].GetTensorMutableData<float>();
-    size_t outSize =
-        outputTensors[0].GetTensorTypeAndShapeInfo().GetElementCount();
-    encoderOutput->data.assign(outData, outData + outSize);
-
-    // Get attention cache
-    float *attCacheOut = outputTensors[1].GetTensorMutableData<float>();
-    size_t attCacheSize =
-        outputTensors[1].GetTensorTypeAndShapeInfo().GetElementCount();
-    encoderOutput->RAttCache.assign(attCacheOut, attCacheOut + attCacheSize);
-
-    // Get CNN cache
-    float *cnnCacheOut = outputTensors[2].GetTensorMutableData<float>();
-    size_t cnnCacheSize =
-        outputTensors[2].GetTensorTypeAndShapeInfo().GetElementCount();
-    encoderOutput->RCNNCache.assign(cnnCacheOut, cnnCacheOut + cnnCacheSize);
+    runBinding({&encoderOutput->data, &encoderOutput->RAttCache,
+                &encoderOutput->RCNNCache});
 
     return true;
   } catch (const Ort::Exception &e) {
@@ -12,6 +12,7 @@
 #define __ONNXRUNTIME_INFERENCE_WENET_ENCODER_H_
 
 #include "dnn_infer.hpp"
+#include <algorithm>
 
 namespace lip_sync::infer::dnn {
 class WeNetEncoderInference : public AlgoInference {
@@ -20,6 +21,32 @@ public:
       : AlgoInference(param) {}
 
   bool infer(AlgoInput &input, AlgoOutput &output) override;
+
+  /**
+   * @brief Whether the model accepts a packed batch of windows, i.e. the
+   * chunk input has a dynamic batch dimension. Batched windows share the
+   * offset and caches of the input, bound with their declared shapes, so
+   * those must be fixed. A model with dynamic cache dimensions, e.g. a
+   * batch dimension of its own, is run one window at a time.
+   */
+  bool supportsBatch() const {
+    if (inputShape.size() < 4 || inputShape[0].empty() ||
+        inputShape[0][0] != -1) {
+      return false;
+    }
+    for (size_t i = 2; i < 4; ++i) {
+      if (std::any_of(inputShape[i].begin(), inputShape[i].end(),
+                      [](int64_t dim) { return dim < 0; })) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  // Chunk shape and position offset of the current run
+  std::vector<int64_t> chunkShape;
+  int64_t offsetData = 0;
 };
 } // namespace lip_sync::infer::dnn
 #endif
@@ -23,6 +23,15 @@ JNIEXPORT jint JNICALL Java_com_example_lipsync_LipSyncSDK_nativeTerminate(
 JNIEXPORT jint JNICALL Java_com_example_lipsync_LipSyncSDK_nativeTryGetNext(
     JNIEnv *env, jclass clazz, jlong handle, jobject output);
 
+JNIEXPORT jint JNICALL
+Java_com_example_lipsync_LipSyncSDK_nativeTryGetNextBatch(
+    JNIEnv *env, jclass clazz, jlong handle, jobjectArray outputs,
+    jint timeoutMs);
+
+JNIEXPORT jint JNICALL
+Java_com_example_lipsync_LipSyncSDK_nativeSetFrameCallback(
+    JNIEnv *env, jclass clazz, jlong handle, jobject listener);
+
 JNIEXPORT jstring JNICALL
 Java_com_example_lipsync_LipSyncSDK_nativeGetVersion(JNIEnv *env, jclass clazz);
 
@@ -8,6 +8,10 @@ extern "C" {
 
 typedef void *LipSyncSDKHandle;
 
+// 帧回调，在 SDK 编码线程中调用，packet 仅在回调期间有效
+typedef void (*LipSyncSDK_FrameCallback)(const lip_sync::OutputPacket *packet,
+                                         void *userData);
+
 LipSyncSDKHandle LipSyncSDK_Create();
 void LipSyncSDK_Destroy(LipSyncSDKHandle handle);
 lip_sync::ErrorCode LipSyncSDK_Initialize(LipSyncSDKHandle handle,
@@ -17,6 +21,43 @@ lip_sync::ErrorCode LipSyncSDK_StartProcess(LipSyncSDKHandle handle,
 lip_sync::ErrorCode LipSyncSDK_Terminate(LipSyncSDKHandle handle);
 lip_sync::ErrorCode LipSyncSDK_TryGetNext(LipSyncSDKHandle handle,
                                           lip_sync::OutputPacket *result);
+lip_sync::ErrorCode LipSyncSDK_TryGetNextBatch(LipSyncSDKHandle handle,
+                                               lip_sync::OutputPacket *results,
+                                               size_t capacity, size_t *count,
+                                               uint32_t timeoutMs);
+lip_sync::ErrorCode
+LipSyncSDK_SetFrameCallback(LipSyncSDKHandle handle,
+                            LipSyncSDK_FrameCallback callback, void *userData);
+lip_sync::ErrorCode LipSyncSDK_BeginSession(LipSyncSDKHandle handle,
+                                            const char *uuid);
+lip_sync::ErrorCode LipSyncSDK_PushAudio(LipSyncSDKHandle handle,
+                                         const char *uuid, const float *data,
+                                         size_t size);
+lip_sync::ErrorCode LipSyncSDK_EndSession(LipSyncSDKHandle handle,
+                                          const char *uuid);
+lip_sync::ErrorCode LipSyncSDK_OpenOutputStream(LipSyncSDKHandle handle,
+                                               const char *uuid);
+lip_sync::ErrorCode
+LipSyncSDK_TryGetNextFromStream(LipSyncSDKHandle handle, const char *uuid,
+                                lip_sync::OutputPacket *result);
+lip_sync::ErrorCode LipSyncSDK_Cancel(LipSyncSDKHandle handle,
+                                      const char *uuid);
+lip_sync::ErrorCode LipSyncSDK_GetStageStats(LipSyncSDKHandle handle,
+                                             lip_sync::StageStats *stats,
+                                             size_t capacity, size_t *count);
+
+// 离线预计算音频特征，结果供 InputPacket::featurePath 使用
+typedef void *LipSyncPrecomputeHandle;
+
+LipSyncPrecomputeHandle LipSyncPrecompute_Create();
+void LipSyncPrecompute_Destroy(LipSyncPrecomputeHandle handle);
+lip_sync::ErrorCode
+LipSyncPrecompute_Initialize(LipSyncPrecomputeHandle handle,
+                             const lip_sync::PrecomputeConfig *config);
+lip_sync::ErrorCode
+LipSyncPrecompute_Process(LipSyncPrecomputeHandle handle,
+                          const lip_sync::InputPacket *input,
+                          const char *featurePath);
 
 const char *LipSyncSDK_GetVersion();
 void LipSyncSDK_GetVersion_Callback(void (*callback)(const char *));
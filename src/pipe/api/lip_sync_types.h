@@ -1,27 +1,116 @@
 #ifndef __LIP_SYNC_TYPES_H__
 #define __LIP_SYNC_TYPES_H__
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace lip_sync {
 
+// 队列满时的处理策略
+enum class OverflowPolicy {
+  BLOCK = 0,      // 阻塞生产者，直到队列有空位
+  REJECT = 1,     // 输入接口立即返回 QUEUE_FULL
+  DROP_OLDEST = 2 // 输入同 REJECT，帧队列丢弃最早的帧，适用于实时会话
+};
+
+// 会话输出缺帧等待超时后的处理策略
+enum class HolePolicy {
+  SKIP = 0,       // 跳过缺失的帧，继续输出后续帧
+  PLACEHOLDER = 1 // 输出只含音频的补位帧，isPlaceholder 为 true
+};
+
+// 单个模型的 ONNX Runtime 会话配置。推理并发由线程数决定，与单次推理的
+// 线程数相互独立：多会话 × 单线程适合吞吐，少会话 × 多线程适合延迟
+struct ModelSessionConfig {
+  uint32_t numSessions{1};         // 会话数，模型实例轮流使用，共享预打包权重
+  uint32_t intraOpThreads{1};      // 单次推理的算子内线程数
+  uint32_t interOpThreads{1};      // 算子间线程数，仅并行执行模式使用
+  bool parallelExecution{false};   // 无依赖的算子并行执行
+  bool allowSpinning{true};        // 空闲线程先自旋再休眠，延迟更低但占用 CPU
+  bool memPattern{true};           // 按首次推理的内存分配模式预分配
+  bool cpuMemArena{true};          // 使用 CPU 内存池
+  bool useGlobalThreadPool{false}; // 使用进程全局线程池，忽略上面的线程数
+};
+
 struct SDKConfig {
-  uint32_t numWorkers{1};       // 工作线程数量
-  std::string wavLipModelPath;  // 唇音同步模型路径
-  std::string encoderModelPath; // 音频编码模型路径
-  std::string frameDir;         // 帧路径
-  uint32_t frameRate;           // 帧率
-  std::string faceInfoPath;     // 人脸信息路径
-  size_t maxCacheSize;          // 图片最大缓存(byte)
-  uint32_t faceSize;            // 人脸图片尺寸
-  uint32_t facePad;             // 人脸图片填充
+  uint32_t numWorkers{1};           // 推理阶段线程数量
+  std::string wavLipModelPath;      // 唇音同步模型路径
+  std::string encoderModelPath;     // 音频编码模型路径
+  std::string frameDir;             // 帧路径
+  uint32_t frameRate;               // 帧率
+  std::string faceInfoPath;         // 人脸信息路径
+  size_t maxCacheSize;              // 图片最大缓存(byte)
+  uint32_t faceSize;                // 人脸图片尺寸
+  uint32_t facePad;                 // 人脸图片填充
+  uint32_t maxBatchSize{1};         // 推理最大批大小，可跨会话凑批
+  uint32_t maxBatchDelayMs{5};      // 凑批最长等待时间(毫秒)
+  uint32_t encoderBatchSize{1};     // 音频编码最大批大小，可跨会话凑批
+  uint32_t numAudioWorkers{1};      // 音频特征阶段线程数量
+  uint32_t numEncoderWorkers{1};    // 音频编码线程数量，各自独占一个编码模型
+  uint32_t numPreprocessWorkers{1}; // 人脸预处理阶段线程数量
+  uint32_t numCompositeWorkers{1};  // 合成阶段线程数量
+  uint32_t numEncodeWorkers{1};     // 编码阶段线程数量
+  uint32_t stageQueueCapacity{32};  // 阶段间队列容量
+  uint32_t inputQueueCapacity{16};  // 输入队列容量，0 表示不限
+  uint32_t outputQueueCapacity{64}; // 输出队列容量，0 表示不限
+  uint32_t holeTimeoutMs{200};      // 缺帧等待超时(毫秒)，0 表示一直等待
+  bool incrementalEncoder{false};   // 音频编码增量模式，每帧 fbank 只编码一次
+  size_t featureCacheSize{0};       // 音频特征内存缓存(byte)，0 表示不缓存
+  std::string featureCacheDir;      // 音频特征磁盘缓存目录，为空表示不使用
+
+  // 各模型的会话配置
+  ModelSessionConfig wavLipSession;
+  ModelSessionConfig encoderSession;
+
+  // 进程全局线程池，供 useGlobalThreadPool 的会话共享，0 表示每核一个线程；
+  // 须在进程内首次加载模型前确定，之后的不同设置不生效
+  uint32_t globalIntraOpThreads{0};
+  uint32_t globalInterOpThreads{0};
+  bool globalAllowSpinning{true};
+
+  // 队列满时的处理策略
+  OverflowPolicy overflowPolicy{OverflowPolicy::BLOCK};
+
+  // 缺帧超时后的处理策略
+  HolePolicy holePolicy{HolePolicy::SKIP};
 };
 
 struct InputPacket {
   std::vector<float> audioData; // 音频数据
   std::string audioPath;        // 音频文件
   std::string uuid;             // 数据标识
+  std::string featurePath;      // 预计算的音频特征文件，设置后不再编码音频
+};
+
+// 离线预计算音频特征的配置，需与使用特征文件的 SDK 的编码配置一致
+struct PrecomputeConfig {
+  std::string encoderModelPath;      // 音频编码模型路径
+  uint32_t encoderBatchSize{1};      // 音频编码最大批大小
+  bool incrementalEncoder{false};    // 音频编码增量模式
+  ModelSessionConfig encoderSession; // 音频编码模型的会话配置
+};
+
+// 音频段视图：引用会话音频缓冲中的一段，拷贝只增加引用计数，
+// 持有期间对应的缓冲不会被释放
+class AudioSegment {
+public:
+  AudioSegment() = default;
+  AudioSegment(std::shared_ptr<const float> data, size_t size)
+      : data_(std::move(data)), size_(size) {}
+
+  const float *data() const { return data_.get(); }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const float *begin() const { return data_.get(); }
+  const float *end() const { return data_.get() + size_; }
+  float operator[](size_t index) const { return data_.get()[index]; }
+
+  std::vector<float> toVector() const { return {begin(), end()}; }
+
+private:
+  std::shared_ptr<const float> data_;
+  size_t size_{0};
 };
 
 struct OutputPacket {
@@ -29,11 +118,23 @@ struct OutputPacket {
   std::vector<uint8_t> frameData; // 生成的视频帧数据
   uint32_t width;                 // 帧宽度
   uint32_t height;                // 帧高度
-  std::vector<float> audioData;   // 对应的音频段数据
+  AudioSegment audioData;         // 对应的音频段数据
   uint32_t sampleRate;            // 音频采样率
   uint32_t channels;              // 音频通道数
   int64_t timestamp;              // 时间戳(微秒)
   int64_t sequence;               // 序列号
+  bool isLastChunk{false};        // 是否是最后一帧
+  bool isPlaceholder{false};      // 是否是缺帧超时的补位帧(无图像数据)
+};
+
+struct StageStats {
+  std::string name;     // 阶段名称
+  uint32_t numThreads;  // 线程数量
+  size_t queueDepth;    // 当前输入队列长度
+  size_t queueCapacity; // 输入队列容量
+  uint64_t processed;   // 已处理数据数量
+  uint64_t busyTimeUs;  // 累计处理耗时(微秒)
+  uint64_t dropped;     // 因队列满被丢弃的数据数量
 };
 
 enum class ErrorCode {
@@ -44,7 +145,9 @@ enum class ErrorCode {
   INITIALIZATION_FAILED = -4,
   PROCESSING_ERROR = -5,
   INVALID_STATE = -6,
-  TRY_GET_NEXT_OVERTIME = -7
+  TRY_GET_NEXT_OVERTIME = -7,
+  QUEUE_FULL = -8,
+  END_OF_STREAM = -9
 };
 } // namespace lip_sync
 #endif
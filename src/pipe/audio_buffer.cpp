@@ -0,0 +1,95 @@
+/**
+ * @file audio_buffer.cpp
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-29
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "audio_buffer.hpp"
+#include <algorithm>
+
+namespace lip_sync {
+
+AudioBuffer::AudioBuffer(size_t samplesPerFrame, size_t framesPerBlock)
+    : samplesPerFrame(samplesPerFrame),
+      samplesPerBlock(samplesPerFrame * std::max<size_t>(framesPerBlock, 1)),
+      silence(std::make_shared<const std::vector<float>>(samplesPerFrame,
+                                                         0.0f)) {}
+
+void AudioBuffer::assign(std::vector<float> &&samples) {
+  std::lock_guard<std::mutex> lock(mutex);
+  blocks.clear();
+  totalSamples = samples.size();
+  blocks.push_back(
+      Block{0, std::make_shared<std::vector<float>>(std::move(samples))});
+}
+
+void AudioBuffer::append(const float *data, size_t size) {
+  std::lock_guard<std::mutex> lock(mutex);
+  while (size > 0) {
+    if (blocks.empty() || blocks.back().samples->size() >= samplesPerBlock) {
+      auto samples = std::make_shared<std::vector<float>>();
+      samples->reserve(samplesPerBlock);
+      blocks.push_back(Block{totalSamples, std::move(samples)});
+    }
+
+    // 只在预留容量内追加，已取出的音频段指向的内存不会移动
+    auto &samples = *blocks.back().samples;
+    const size_t count = std::min(size, samplesPerBlock - samples.size());
+    samples.insert(samples.end(), data, data + count);
+    totalSamples += count;
+    data += count;
+    size -= count;
+  }
+}
+
+AudioSegment AudioBuffer::segment(size_t frameIndex) const {
+  const size_t start = frameIndex * samplesPerFrame;
+  std::lock_guard<std::mutex> lock(mutex);
+
+  auto iter = std::upper_bound(
+      blocks.begin(), blocks.end(), start,
+      [](size_t sample, const Block &block) { return sample < block.start; });
+  if (start >= totalSamples || iter == blocks.begin()) {
+    return AudioSegment{std::shared_ptr<const float>(silence, silence->data()),
+                        samplesPerFrame};
+  }
+
+  const auto &block = *std::prev(iter);
+  const size_t offset = start - block.start;
+  const size_t size =
+      std::min(samplesPerFrame, block.samples->size() - offset);
+  return AudioSegment{
+      std::shared_ptr<const float>(block.samples,
+                                   block.samples->data() + offset),
+      size};
+}
+
+void AudioBuffer::release(size_t frameIndex) {
+  const size_t start = frameIndex * samplesPerFrame;
+  std::lock_guard<std::mutex> lock(mutex);
+  // 末尾的块可能仍在写入，始终保留
+  while (blocks.size() > 1 &&
+         blocks.front().start + blocks.front().samples->size() <= start) {
+    blocks.pop_front();
+  }
+}
+
+void AudioBuffer::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  blocks.clear();
+}
+
+size_t AudioBuffer::heldSamples() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  size_t held = 0;
+  for (const auto &block : blocks) {
+    held += block.samples->size();
+  }
+  return held;
+}
+
+} // namespace lip_sync
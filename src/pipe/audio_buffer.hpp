@@ -0,0 +1,63 @@
+/**
+ * @file audio_buffer.hpp
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief 会话音频缓冲：按帧对齐分块存储，逐帧取出共享引用的音频段
+ * @version 0.1
+ * @date 2024-12-29
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __AUDIO_BUFFER_HPP__
+#define __AUDIO_BUFFER_HPP__
+
+#include "lip_sync_types.h"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lip_sync {
+
+class AudioBuffer {
+public:
+  // 块大小为帧长的整数倍，每帧的音频段总落在一个块内，取出时无需拷贝
+  explicit AudioBuffer(size_t samplesPerFrame, size_t framesPerBlock = 256);
+
+  // 整段音频：接管数据作为一个块，不拷贝
+  void assign(std::vector<float> &&samples);
+
+  // 流式音频：追加到末尾的块，块写满后新建，已有块不会重新分配
+  void append(const float *data, size_t size);
+
+  // 第 frameIndex 帧的音频段，超出已有音频的部分截断，完全超出或
+  // 已被释放时返回一帧静音
+  AudioSegment segment(size_t frameIndex) const;
+
+  // 释放 frameIndex 帧之前的块，已取出的音频段仍然有效
+  void release(size_t frameIndex);
+
+  void clear();
+
+  // 当前持有的采样点数
+  size_t heldSamples() const;
+
+private:
+  struct Block {
+    size_t start; // 块首采样点在会话音频中的位置
+    std::shared_ptr<std::vector<float>> samples;
+  };
+
+  const size_t samplesPerFrame;
+  const size_t samplesPerBlock;
+  std::shared_ptr<const std::vector<float>> silence;
+
+  mutable std::mutex mutex;
+  std::deque<Block> blocks;
+  size_t totalSamples = 0;
+};
+
+} // namespace lip_sync
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @file feature_precompute.cpp
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-01-09
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "feature_precompute.hpp"
+#include "audio/audio_processor.hpp"
+#include "core/feature_cache.hpp"
+#include "core/feature_extractor.hpp"
+#include "core/feature_file.hpp"
+#include "logger/logger.hpp"
+#include "wav_lip_manager.hpp"
+#include <mutex>
+
+namespace lip_sync {
+
+using namespace lip_sync::infer;
+
+class FeaturePrecomputeImpl {
+public:
+  ErrorCode initialize(const PrecomputeConfig &config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    WeNetConfig wenetConfig;
+    wenetConfig.modelPath = config.encoderModelPath;
+    wenetConfig.incremental = config.incrementalEncoder;
+    wenetConfig.batchSize = std::max<uint32_t>(config.encoderBatchSize, 1);
+    wenetConfig.session = toSessionConfig(config.encoderSession);
+
+    auto extractor =
+        std::make_unique<FeatureExtractor>(FbankConfig{}, wenetConfig);
+    if (!extractor->initialize()) {
+      LOGGER_ERROR("Failed to initialize feature extractor");
+      return ErrorCode::INITIALIZATION_FAILED;
+    }
+    extractor_ = std::move(extractor);
+    modelKey_ = FeatureCache::modelKey(config.encoderModelPath, FbankConfig{},
+                                       wenetConfig);
+    return ErrorCode::SUCCESS;
+  }
+
+  ErrorCode process(const InputPacket &input, const std::string &featurePath) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!extractor_) {
+      return ErrorCode::INVALID_STATE;
+    }
+
+    audio::AudioProcessor audioProcessor;
+    std::vector<float> audio = input.audioData.empty()
+                                   ? audioProcessor.readAudio(input.audioPath)
+                                   : input.audioData;
+    if (audio.empty()) {
+      LOGGER_ERROR("No audio for {}", input.uuid);
+      return input.audioData.empty() ? ErrorCode::FILE_NOT_FOUND
+                                     : ErrorCode::INVALID_INPUT;
+    }
+
+    // 与 SDK 整段输入相同的预处理与特征，键与特征缓存一致
+    auto preprocessed = audioProcessor.preprocess(audio);
+    std::vector<cv::Mat> features;
+    try {
+      features = extractor_->extractWenetFeatures(
+          extractor_->computeFbank(preprocessed));
+    } catch (const std::exception &e) {
+      LOGGER_ERROR("Failed to extract features of {}: {}", input.uuid,
+                   e.what());
+      return ErrorCode::PROCESSING_ERROR;
+    }
+
+    const uint64_t key = FeatureCache::hash(
+        preprocessed.data(), preprocessed.size() * sizeof(float), modelKey_);
+    if (!FeatureFile::write(featurePath, features, audio, key, modelKey_)) {
+      return ErrorCode::PROCESSING_ERROR;
+    }
+    return ErrorCode::SUCCESS;
+  }
+
+private:
+  std::unique_ptr<FeatureExtractor> extractor_;
+  uint64_t modelKey_ = 0;
+  std::mutex mutex_;
+};
+
+FeaturePrecompute::FeaturePrecompute()
+    : impl_(std::make_unique<FeaturePrecomputeImpl>()) {}
+
+FeaturePrecompute::~FeaturePrecompute() = default;
+
+ErrorCode FeaturePrecompute::initialize(const PrecomputeConfig &config) {
+  if (!impl_) {
+    return ErrorCode::INITIALIZATION_FAILED;
+  }
+  return impl_->initialize(config);
+}
+
+ErrorCode FeaturePrecompute::process(const InputPacket &input,
+                                     const std::string &featurePath) {
+  if (!impl_) {
+    return ErrorCode::INVALID_STATE;
+  }
+  return impl_->process(input, featurePath);
+}
+
+} // namespace lip_sync
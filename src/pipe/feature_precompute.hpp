@@ -0,0 +1,44 @@
+/**
+ * @file feature_precompute.hpp
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-01-09
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __LIP_SYNC_FEATURE_PRECOMPUTE_HPP__
+#define __LIP_SYNC_FEATURE_PRECOMPUTE_HPP__
+#include "lip_sync_types.h"
+#include <memory>
+#include <string>
+
+namespace lip_sync {
+
+class FeaturePrecomputeImpl;
+
+// 离线预计算音频特征：只运行音频预处理与特征提取，结果连同音频写入
+// 特征文件，供 InputPacket::featurePath 使用。各次调用串行执行，多线程
+// 并行时每个线程使用各自的实例
+class FeaturePrecompute {
+public:
+  FeaturePrecompute();
+  ~FeaturePrecompute();
+
+  ErrorCode initialize(const PrecomputeConfig &config);
+
+  // 计算 input 中音频（audioData 或 audioPath）的特征，写入 featurePath
+  ErrorCode process(const InputPacket &input, const std::string &featurePath);
+
+private:
+  std::unique_ptr<FeaturePrecomputeImpl> impl_;
+
+  FeaturePrecompute(const FeaturePrecompute &) = delete;
+  FeaturePrecompute &operator=(const FeaturePrecompute &) = delete;
+};
+
+} // namespace lip_sync
+
+#endif
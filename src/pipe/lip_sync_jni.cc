@@ -1,7 +1,9 @@
 #include "api/lip_sync_jni.h"
 #include "lip_sync_sdk.h"
 #include "logger/logger.hpp"
+#include <algorithm>
 #include <android/log.h>
+#include <memory>
 #include <vector>
 
 #define LOG_TAG "LipSyncJNI"
@@ -20,6 +22,90 @@ static std::string jstring2string(JNIEnv *env, jstring jstr) {
   return result;
 }
 
+// 工具函数：读取可选的 int 字段，旧版 Java 类缺少该字段时返回默认值
+static jint getOptionalIntField(JNIEnv *env, jobject obj, jclass clazz,
+                                const char *name, jint defaultValue) {
+  jfieldID field = env->GetFieldID(clazz, name, "I");
+  if (!field) {
+    env->ExceptionClear();
+    return defaultValue;
+  }
+  return env->GetIntField(obj, field);
+}
+
+// 工具函数：读取可选的 long 字段，旧版 Java 类缺少该字段时返回默认值
+static jlong getOptionalLongField(JNIEnv *env, jobject obj, jclass clazz,
+                                  const char *name, jlong defaultValue) {
+  jfieldID field = env->GetFieldID(clazz, name, "J");
+  if (!field) {
+    env->ExceptionClear();
+    return defaultValue;
+  }
+  return env->GetLongField(obj, field);
+}
+
+// 工具函数：读取可选的 String 字段，缺少该字段或为 null 时返回空串
+static std::string getOptionalStringField(JNIEnv *env, jobject obj,
+                                          jclass clazz, const char *name) {
+  jfieldID field = env->GetFieldID(clazz, name, "Ljava/lang/String;");
+  if (!field) {
+    env->ExceptionClear();
+    return {};
+  }
+  return jstring2string(env, (jstring)env->GetObjectField(obj, field));
+}
+
+// 工具函数：读取可选的 boolean 字段，旧版 Java 类缺少该字段时返回默认值
+static bool getOptionalBooleanField(JNIEnv *env, jobject obj, jclass clazz,
+                                    const char *name, bool defaultValue) {
+  jfieldID field = env->GetFieldID(clazz, name, "Z");
+  if (!field) {
+    env->ExceptionClear();
+    return defaultValue;
+  }
+  return env->GetBooleanField(obj, field) == JNI_TRUE;
+}
+
+// 工具函数：读取以 prefix 开头的一组可选会话配置字段，如 wavLipIntraOpThreads
+static ModelSessionConfig getSessionConfig(JNIEnv *env, jobject obj,
+                                           jclass clazz,
+                                           const std::string &prefix) {
+  ModelSessionConfig config;
+  auto name = [&](const char *field) { return prefix + field; };
+  config.numSessions = getOptionalIntField(
+      env, obj, clazz, name("NumSessions").c_str(), config.numSessions);
+  config.intraOpThreads = getOptionalIntField(
+      env, obj, clazz, name("IntraOpThreads").c_str(), config.intraOpThreads);
+  config.interOpThreads = getOptionalIntField(
+      env, obj, clazz, name("InterOpThreads").c_str(), config.interOpThreads);
+  config.parallelExecution =
+      getOptionalBooleanField(env, obj, clazz,
+                              name("ParallelExecution").c_str(),
+                              config.parallelExecution);
+  config.allowSpinning = getOptionalBooleanField(
+      env, obj, clazz, name("AllowSpinning").c_str(), config.allowSpinning);
+  config.memPattern = getOptionalBooleanField(
+      env, obj, clazz, name("MemPattern").c_str(), config.memPattern);
+  config.cpuMemArena = getOptionalBooleanField(
+      env, obj, clazz, name("CpuMemArena").c_str(), config.cpuMemArena);
+  config.useGlobalThreadPool =
+      getOptionalBooleanField(env, obj, clazz,
+                              name("UseGlobalThreadPool").c_str(),
+                              config.useGlobalThreadPool);
+  return config;
+}
+
+// 工具函数：写入可选的 boolean 字段，旧版 Java 类缺少该字段时忽略
+static void setOptionalBooleanField(JNIEnv *env, jobject obj, jclass clazz,
+                                    const char *name, bool value) {
+  jfieldID field = env->GetFieldID(clazz, name, "Z");
+  if (!field) {
+    env->ExceptionClear();
+    return;
+  }
+  env->SetBooleanField(obj, field, value ? JNI_TRUE : JNI_FALSE);
+}
+
 // 工具函数：std::string 转 Java String
 static jstring string2jstring(JNIEnv *env, const std::string &str) {
   return env->NewStringUTF(str.c_str());
@@ -36,9 +122,9 @@ static jbyteArray vector_uint8_to_jbyteArray(JNIEnv *env,
   return result;
 }
 
-// 工具函数：std::vector<float> 转 float[]
-static jfloatArray vector_float_to_jfloatArray(JNIEnv *env,
-                                               const std::vector<float> &data) {
+// 工具函数：音频段转 float[]
+static jfloatArray audio_segment_to_jfloatArray(JNIEnv *env,
+                                                const AudioSegment &data) {
   jfloatArray result = env->NewFloatArray(data.size());
   if (result) {
     env->SetFloatArrayRegion(result, 0, data.size(), data.data());
@@ -46,6 +132,131 @@ static jfloatArray vector_float_to_jfloatArray(JNIEnv *env,
   return result;
 }
 
+// 工具函数：C++ OutputPacket 写入已创建的 Java OutputPacket
+static void fillOutputPacket(JNIEnv *env, jobject output,
+                             const OutputPacket &packet) {
+  jclass outputClass = env->GetObjectClass(output);
+  jfieldID uuidField =
+      env->GetFieldID(outputClass, "uuid", "Ljava/lang/String;");
+  jfieldID frameDataField = env->GetFieldID(outputClass, "frameData", "[B");
+  jfieldID widthField = env->GetFieldID(outputClass, "width", "I");
+  jfieldID heightField = env->GetFieldID(outputClass, "height", "I");
+  jfieldID audioDataField = env->GetFieldID(outputClass, "audioData", "[F");
+  jfieldID sampleRateField = env->GetFieldID(outputClass, "sampleRate", "I");
+  jfieldID channelsField = env->GetFieldID(outputClass, "channels", "I");
+  jfieldID timestampField = env->GetFieldID(outputClass, "timestamp", "J");
+  jfieldID sequenceField = env->GetFieldID(outputClass, "sequence", "J");
+
+  // 字段赋值会创建局部引用，批量填充时及时释放
+  jstring uuid = string2jstring(env, packet.uuid);
+  jbyteArray frameData = vector_uint8_to_jbyteArray(env, packet.frameData);
+  jfloatArray audioData = audio_segment_to_jfloatArray(env, packet.audioData);
+  env->SetObjectField(output, uuidField, uuid);
+  env->SetObjectField(output, frameDataField, frameData);
+  env->SetIntField(output, widthField, packet.width);
+  env->SetIntField(output, heightField, packet.height);
+  env->SetObjectField(output, audioDataField, audioData);
+  env->SetIntField(output, sampleRateField, packet.sampleRate);
+  env->SetIntField(output, channelsField, packet.channels);
+  env->SetLongField(output, timestampField, packet.timestamp);
+  env->SetLongField(output, sequenceField, packet.sequence);
+  setOptionalBooleanField(env, output, outputClass, "isPlaceholder",
+                          packet.isPlaceholder);
+  env->DeleteLocalRef(uuid);
+  env->DeleteLocalRef(frameData);
+  env->DeleteLocalRef(audioData);
+  env->DeleteLocalRef(outputClass);
+}
+
+// Java 帧回调：持有监听器与 OutputPacket 类的全局引用，在编码线程中调用
+class JavaFrameSink {
+public:
+  JavaFrameSink(JNIEnv *env, jobject listener) {
+    env->GetJavaVM(&vm);
+    this->listener = env->NewGlobalRef(listener);
+    jclass listenerClass = env->GetObjectClass(listener);
+    onFrame = env->GetMethodID(listenerClass, "onFrame",
+                               "(Lcom/example/lipsync/OutputPacket;)V");
+    env->DeleteLocalRef(listenerClass);
+    if (env->ExceptionCheck()) {
+      env->ExceptionClear();
+    }
+
+    // 编码线程挂载到 JVM 后只能看到系统类加载器，类需在此处查找
+    jclass localClass = env->FindClass("com/example/lipsync/OutputPacket");
+    if (localClass) {
+      outputClass = static_cast<jclass>(env->NewGlobalRef(localClass));
+      outputInit = env->GetMethodID(outputClass, "<init>", "()V");
+      env->DeleteLocalRef(localClass);
+    }
+    if (env->ExceptionCheck()) {
+      env->ExceptionClear();
+    }
+  }
+
+  ~JavaFrameSink() {
+    JNIEnv *env = getEnv();
+    if (env) {
+      env->DeleteGlobalRef(listener);
+      if (outputClass) {
+        env->DeleteGlobalRef(outputClass);
+      }
+    }
+  }
+
+  bool valid() const { return onFrame && outputClass && outputInit; }
+
+  void operator()(const OutputPacket &packet) {
+    JNIEnv *env = getEnv();
+    if (!env) {
+      LOGE("Failed to attach encode thread to JVM");
+      return;
+    }
+    jobject output = env->NewObject(outputClass, outputInit);
+    if (!output) {
+      env->ExceptionClear();
+      return;
+    }
+    fillOutputPacket(env, output, packet);
+    env->CallVoidMethod(listener, onFrame, output);
+    if (env->ExceptionCheck()) {
+      env->ExceptionDescribe();
+      env->ExceptionClear();
+    }
+    env->DeleteLocalRef(output);
+  }
+
+private:
+  // 编码线程首次回调时挂载到 JVM，线程退出时卸载
+  JNIEnv *getEnv() {
+    JNIEnv *env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) ==
+        JNI_OK) {
+      return env;
+    }
+    if (vm->AttachCurrentThread(&env, nullptr) != JNI_OK) {
+      return nullptr;
+    }
+    struct ThreadDetacher {
+      JavaVM *vm = nullptr;
+      ~ThreadDetacher() {
+        if (vm) {
+          vm->DetachCurrentThread();
+        }
+      }
+    };
+    thread_local ThreadDetacher detacher;
+    detacher.vm = vm;
+    return env;
+  }
+
+  JavaVM *vm = nullptr;
+  jobject listener = nullptr;
+  jmethodID onFrame = nullptr;
+  jclass outputClass = nullptr;
+  jmethodID outputInit = nullptr;
+};
+
 // 创建 SDK 实例
 JNIEXPORT jlong JNICALL
 Java_com_example_lipsync_LipSyncSDK_nativeCreate(JNIEnv *env, jclass clazz) {
@@ -115,6 +326,52 @@ JNIEXPORT jint JNICALL Java_com_example_lipsync_LipSyncSDK_nativeInitialize(
     config.maxCacheSize = env->GetLongField(jconfig, maxCacheSizeField);
     config.faceSize = env->GetIntField(jconfig, faceSizeField);
     config.facePad = env->GetIntField(jconfig, facePadField);
+    config.maxBatchSize = getOptionalIntField(env, jconfig, configClass,
+                                              "maxBatchSize", 1);
+    config.maxBatchDelayMs = getOptionalIntField(env, jconfig, configClass,
+                                                 "maxBatchDelayMs", 5);
+    config.encoderBatchSize = getOptionalIntField(env, jconfig, configClass,
+                                                  "encoderBatchSize", 1);
+    config.numAudioWorkers = getOptionalIntField(env, jconfig, configClass,
+                                                 "numAudioWorkers", 1);
+    config.numEncoderWorkers = getOptionalIntField(
+        env, jconfig, configClass, "numEncoderWorkers", 1);
+    config.numPreprocessWorkers = getOptionalIntField(
+        env, jconfig, configClass, "numPreprocessWorkers", 1);
+    config.numCompositeWorkers = getOptionalIntField(
+        env, jconfig, configClass, "numCompositeWorkers", 1);
+    config.numEncodeWorkers = getOptionalIntField(env, jconfig, configClass,
+                                                  "numEncodeWorkers", 1);
+    config.stageQueueCapacity = getOptionalIntField(
+        env, jconfig, configClass, "stageQueueCapacity", 32);
+    config.inputQueueCapacity = getOptionalIntField(
+        env, jconfig, configClass, "inputQueueCapacity", 16);
+    config.outputQueueCapacity = getOptionalIntField(
+        env, jconfig, configClass, "outputQueueCapacity", 64);
+    config.overflowPolicy = static_cast<OverflowPolicy>(getOptionalIntField(
+        env, jconfig, configClass, "overflowPolicy",
+        static_cast<jint>(OverflowPolicy::BLOCK)));
+    config.holeTimeoutMs = getOptionalIntField(env, jconfig, configClass,
+                                               "holeTimeoutMs", 200);
+    config.holePolicy = static_cast<HolePolicy>(
+        getOptionalIntField(env, jconfig, configClass, "holePolicy",
+                            static_cast<jint>(HolePolicy::SKIP)));
+    config.incrementalEncoder = getOptionalBooleanField(
+        env, jconfig, configClass, "incrementalEncoder", false);
+    config.featureCacheSize = getOptionalLongField(
+        env, jconfig, configClass, "featureCacheSize", 0);
+    config.featureCacheDir =
+        getOptionalStringField(env, jconfig, configClass, "featureCacheDir");
+    config.wavLipSession =
+        getSessionConfig(env, jconfig, configClass, "wavLip");
+    config.encoderSession =
+        getSessionConfig(env, jconfig, configClass, "encoder");
+    config.globalIntraOpThreads = getOptionalIntField(
+        env, jconfig, configClass, "globalIntraOpThreads", 0);
+    config.globalInterOpThreads = getOptionalIntField(
+        env, jconfig, configClass, "globalInterOpThreads", 0);
+    config.globalAllowSpinning = getOptionalBooleanField(
+        env, jconfig, configClass, "globalAllowSpinning", true);
 
     return static_cast<jint>(sdk->initialize(config));
   } catch (const std::exception &e) {
@@ -142,16 +399,21 @@ JNIEXPORT jint JNICALL Java_com_example_lipsync_LipSyncSDK_nativeStartProcess(
 
     // 构建 C++ InputPacket 对象
     InputPacket inputPacket;
+    // 特征文件输入时音频数据可以为 null
     jfloatArray audioData =
         (jfloatArray)env->GetObjectField(input, audioDataField);
-    jsize audioDataSize = env->GetArrayLength(audioData);
-    inputPacket.audioData.resize(audioDataSize);
-    env->GetFloatArrayRegion(audioData, 0, audioDataSize,
-                             inputPacket.audioData.data());
+    if (audioData) {
+      jsize audioDataSize = env->GetArrayLength(audioData);
+      inputPacket.audioData.resize(audioDataSize);
+      env->GetFloatArrayRegion(audioData, 0, audioDataSize,
+                               inputPacket.audioData.data());
+    }
     inputPacket.audioPath = jstring2string(
         env, (jstring)env->GetObjectField(input, audioPathField));
     inputPacket.uuid =
         jstring2string(env, (jstring)env->GetObjectField(input, uuidField));
+    inputPacket.featurePath =
+        getOptionalStringField(env, input, inputClass, "featurePath");
 
     return static_cast<jint>(sdk->startProcess(inputPacket));
   } catch (const std::exception &e) {
@@ -191,34 +453,7 @@ JNIEXPORT jint JNICALL Java_com_example_lipsync_LipSyncSDK_nativeTryGetNext(
     ErrorCode result = sdk->tryGetNext(outPacket);
 
     if (result == ErrorCode::SUCCESS) {
-      // 获取 OutputPacket 类的字段 ID
-      jclass outputClass = env->GetObjectClass(output);
-      jfieldID uuidField =
-          env->GetFieldID(outputClass, "uuid", "Ljava/lang/String;");
-      jfieldID frameDataField = env->GetFieldID(outputClass, "frameData", "[B");
-      jfieldID widthField = env->GetFieldID(outputClass, "width", "I");
-      jfieldID heightField = env->GetFieldID(outputClass, "height", "I");
-      jfieldID audioDataField = env->GetFieldID(outputClass, "audioData", "[F");
-      jfieldID sampleRateField =
-          env->GetFieldID(outputClass, "sampleRate", "I");
-      jfieldID channelsField = env->GetFieldID(outputClass, "channels", "I");
-      jfieldID timestampField = env->GetFieldID(outputClass, "timestamp", "J");
-      jfieldID sequenceField = env->GetFieldID(outputClass, "sequence", "J");
-
-      // 设置 Java OutputPacket 的字段
-      env->SetObjectField(output, uuidField,
-                          string2jstring(env, outPacket.uuid));
-      env->SetObjectField(output, frameDataField,
-                          vector_uint8_to_jbyteArray(env, outPacket.frameData));
-      env->SetIntField(output, widthField, outPacket.width);
-      env->SetIntField(output, heightField, outPacket.height);
-      env->SetObjectField(
-          output, audioDataField,
-          vector_float_to_jfloatArray(env, outPacket.audioData));
-      env->SetIntField(output, sampleRateField, outPacket.sampleRate);
-      env->SetIntField(output, channelsField, outPacket.channels);
-      env->SetLongField(output, timestampField, outPacket.timestamp);
-      env->SetLongField(output, sequenceField, outPacket.sequence);
+      fillOutputPacket(env, output, outPacket);
     }
 
     return static_cast<jint>(result);
@@ -228,6 +463,69 @@ JNIEXPORT jint JNICALL Java_com_example_lipsync_LipSyncSDK_nativeTryGetNext(
   }
 }
 
+// 批量获取帧数据，填充 outputs 中预先创建的对象，成功时返回帧数，否则返回错误码
+JNIEXPORT jint JNICALL
+Java_com_example_lipsync_LipSyncSDK_nativeTryGetNextBatch(
+    JNIEnv *env, jclass clazz, jlong handle, jobjectArray outputs,
+    jint timeoutMs) {
+  if (!handle)
+    return static_cast<jint>(ErrorCode::INVALID_STATE);
+  if (!outputs || env->GetArrayLength(outputs) == 0)
+    return static_cast<jint>(ErrorCode::INVALID_INPUT);
+
+  try {
+    auto *sdk = reinterpret_cast<LipSyncSDK *>(handle);
+
+    std::vector<OutputPacket> packets;
+    ErrorCode result =
+        sdk->tryGetNextBatch(packets, env->GetArrayLength(outputs),
+                             static_cast<uint32_t>(std::max(timeoutMs, 0)));
+    if (result != ErrorCode::SUCCESS) {
+      return static_cast<jint>(result);
+    }
+
+    for (size_t i = 0; i < packets.size(); ++i) {
+      jobject output = env->GetObjectArrayElement(outputs, i);
+      if (!output) {
+        LOGE("Output array element %zu is null", i);
+        return static_cast<jint>(ErrorCode::INVALID_INPUT);
+      }
+      fillOutputPacket(env, output, packets[i]);
+      env->DeleteLocalRef(output);
+    }
+    return static_cast<jint>(packets.size());
+  } catch (const std::exception &e) {
+    LOGE("Failed to get next frames: %s", e.what());
+    return static_cast<jint>(ErrorCode::PROCESSING_ERROR);
+  }
+}
+
+// 注册帧回调，listener 为 null 时取消注册
+JNIEXPORT jint JNICALL
+Java_com_example_lipsync_LipSyncSDK_nativeSetFrameCallback(
+    JNIEnv *env, jclass clazz, jlong handle, jobject listener) {
+  if (!handle)
+    return static_cast<jint>(ErrorCode::INVALID_STATE);
+
+  try {
+    auto *sdk = reinterpret_cast<LipSyncSDK *>(handle);
+    if (!listener) {
+      return static_cast<jint>(sdk->setFrameCallback(nullptr));
+    }
+
+    auto sink = std::make_shared<JavaFrameSink>(env, listener);
+    if (!sink->valid()) {
+      LOGE("Frame listener must implement onFrame(OutputPacket)");
+      return static_cast<jint>(ErrorCode::INVALID_INPUT);
+    }
+    return static_cast<jint>(sdk->setFrameCallback(
+        [sink](const OutputPacket &packet) { (*sink)(packet); }));
+  } catch (const std::exception &e) {
+    LOGE("Failed to set frame callback: %s", e.what());
+    return static_cast<jint>(ErrorCode::PROCESSING_ERROR);
+  }
+}
+
 // 获取版本信息
 JNIEXPORT jstring JNICALL Java_com_example_lipsync_LipSyncSDK_nativeGetVersion(
     JNIEnv *env, jclass clazz) {
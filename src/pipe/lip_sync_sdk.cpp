@@ -51,6 +51,72 @@ ErrorCode LipSyncSDK::tryGetNext(OutputPacket &result) {
   return impl_->tryGetNext(result);
 }
 
+ErrorCode LipSyncSDK::tryGetNextBatch(std::vector<OutputPacket> &results,
+                                      size_t maxCount, uint32_t timeoutMs) {
+  if (!impl_) {
+    return ErrorCode::INVALID_STATE;
+  }
+  return impl_->tryGetNextBatch(results, maxCount, timeoutMs);
+}
+
+ErrorCode LipSyncSDK::setFrameCallback(FrameCallback callback) {
+  if (!impl_) {
+    return ErrorCode::INVALID_STATE;
+  }
+  return impl_->setFrameCallback(std::move(callback));
+}
+
+ErrorCode LipSyncSDK::beginSession(const std::string &uuid) {
+  if (!impl_) {
+    return ErrorCode::INVALID_STATE;
+  }
+  return impl_->beginSession(uuid);
+}
+
+ErrorCode LipSyncSDK::pushAudio(const std::string &uuid, const float *data,
+                                size_t size) {
+  if (!impl_) {
+    return ErrorCode::INVALID_STATE;
+  }
+  return impl_->pushAudio(uuid, data, size);
+}
+
+ErrorCode LipSyncSDK::endSession(const std::string &uuid) {
+  if (!impl_) {
+    return ErrorCode::INVALID_STATE;
+  }
+  return impl_->endSession(uuid);
+}
+
+ErrorCode LipSyncSDK::openOutputStream(const std::string &uuid) {
+  if (!impl_) {
+    return ErrorCode::INVALID_STATE;
+  }
+  return impl_->openOutputStream(uuid);
+}
+
+ErrorCode LipSyncSDK::tryGetNext(const std::string &uuid,
+                                 OutputPacket &result) {
+  if (!impl_) {
+    return ErrorCode::INVALID_STATE;
+  }
+  return impl_->tryGetNext(uuid, result);
+}
+
+ErrorCode LipSyncSDK::cancel(const std::string &uuid) {
+  if (!impl_) {
+    return ErrorCode::INVALID_STATE;
+  }
+  return impl_->cancel(uuid);
+}
+
+ErrorCode LipSyncSDK::getStageStats(std::vector<StageStats> &stats) {
+  if (!impl_) {
+    return ErrorCode::INVALID_STATE;
+  }
+  return impl_->getStageStats(stats);
+}
+
 std::string LipSyncSDK::getVersion() { return "1.0.0"; }
 
 } // namespace lip_sync
\ No newline at end of file
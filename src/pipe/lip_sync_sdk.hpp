@@ -12,13 +12,18 @@
 #ifndef __LIP_SYNC_SDK_HPP__
 #define __LIP_SYNC_SDK_HPP__
 #include "lip_sync_types.h"
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace lip_sync {
 
 class LipSyncSDKImpl;
 
+// 帧回调，在编码线程中调用
+using FrameCallback = std::function<void(const OutputPacket &packet)>;
+
 class LipSyncSDK {
 public:
   LipSyncSDK();
@@ -32,6 +37,25 @@ public:
 
   ErrorCode tryGetNext(OutputPacket &result);
 
+  ErrorCode tryGetNextBatch(std::vector<OutputPacket> &results,
+                            size_t maxCount, uint32_t timeoutMs = 100);
+
+  ErrorCode setFrameCallback(FrameCallback callback);
+
+  ErrorCode beginSession(const std::string &uuid);
+
+  ErrorCode pushAudio(const std::string &uuid, const float *data, size_t size);
+
+  ErrorCode endSession(const std::string &uuid);
+
+  ErrorCode openOutputStream(const std::string &uuid);
+
+  ErrorCode tryGetNext(const std::string &uuid, OutputPacket &result);
+
+  ErrorCode cancel(const std::string &uuid);
+
+  ErrorCode getStageStats(std::vector<StageStats> &stats);
+
   static std::string getVersion();
 
 private:
@@ -9,9 +9,11 @@
  *
  */
 
+#include "feature_precompute.hpp"
 #include "lip_sync_sdk.h"
 #include "lip_sync_sdk.hpp"
 #include "lip_sync_types.h"
+#include <algorithm>
 #include <string.h>
 
 LipSyncSDKHandle LipSyncSDK_Create() {
@@ -62,6 +64,148 @@ lip_sync::ErrorCode LipSyncSDK_TryGetNext(LipSyncSDKHandle handle,
   return sdk->tryGetNext(*result);
 }
 
+lip_sync::ErrorCode LipSyncSDK_TryGetNextBatch(LipSyncSDKHandle handle,
+                                               lip_sync::OutputPacket *results,
+                                               size_t capacity, size_t *count,
+                                               uint32_t timeoutMs) {
+  if (!handle || !results || !count || capacity == 0) {
+    return lip_sync::ErrorCode::INVALID_INPUT;
+  }
+  lip_sync::LipSyncSDK *sdk = (lip_sync::LipSyncSDK *)handle;
+  std::vector<lip_sync::OutputPacket> packets;
+  *count = 0;
+  auto ret = sdk->tryGetNextBatch(packets, capacity, timeoutMs);
+  if (ret != lip_sync::ErrorCode::SUCCESS) {
+    return ret;
+  }
+  *count = packets.size();
+  std::move(packets.begin(), packets.end(), results);
+  return lip_sync::ErrorCode::SUCCESS;
+}
+
+lip_sync::ErrorCode
+LipSyncSDK_SetFrameCallback(LipSyncSDKHandle handle,
+                            LipSyncSDK_FrameCallback callback, void *userData) {
+  if (!handle) {
+    return lip_sync::ErrorCode::INVALID_INPUT;
+  }
+  lip_sync::LipSyncSDK *sdk = (lip_sync::LipSyncSDK *)handle;
+  if (!callback) {
+    return sdk->setFrameCallback(nullptr);
+  }
+  return sdk->setFrameCallback(
+      [callback, userData](const lip_sync::OutputPacket &packet) {
+        callback(&packet, userData);
+      });
+}
+
+lip_sync::ErrorCode LipSyncSDK_BeginSession(LipSyncSDKHandle handle,
+                                            const char *uuid) {
+  if (!handle || !uuid) {
+    return lip_sync::ErrorCode::INVALID_INPUT;
+  }
+  lip_sync::LipSyncSDK *sdk = (lip_sync::LipSyncSDK *)handle;
+  return sdk->beginSession(uuid);
+}
+
+lip_sync::ErrorCode LipSyncSDK_PushAudio(LipSyncSDKHandle handle,
+                                         const char *uuid, const float *data,
+                                         size_t size) {
+  if (!handle || !uuid) {
+    return lip_sync::ErrorCode::INVALID_INPUT;
+  }
+  lip_sync::LipSyncSDK *sdk = (lip_sync::LipSyncSDK *)handle;
+  return sdk->pushAudio(uuid, data, size);
+}
+
+lip_sync::ErrorCode LipSyncSDK_EndSession(LipSyncSDKHandle handle,
+                                          const char *uuid) {
+  if (!handle || !uuid) {
+    return lip_sync::ErrorCode::INVALID_INPUT;
+  }
+  lip_sync::LipSyncSDK *sdk = (lip_sync::LipSyncSDK *)handle;
+  return sdk->endSession(uuid);
+}
+
+lip_sync::ErrorCode LipSyncSDK_OpenOutputStream(LipSyncSDKHandle handle,
+                                               const char *uuid) {
+  if (!handle || !uuid) {
+    return lip_sync::ErrorCode::INVALID_INPUT;
+  }
+  lip_sync::LipSyncSDK *sdk = (lip_sync::LipSyncSDK *)handle;
+  return sdk->openOutputStream(uuid);
+}
+
+lip_sync::ErrorCode
+LipSyncSDK_TryGetNextFromStream(LipSyncSDKHandle handle, const char *uuid,
+                                lip_sync::OutputPacket *result) {
+  if (!handle || !uuid || !result) {
+    return lip_sync::ErrorCode::INVALID_INPUT;
+  }
+  lip_sync::LipSyncSDK *sdk = (lip_sync::LipSyncSDK *)handle;
+  return sdk->tryGetNext(uuid, *result);
+}
+
+lip_sync::ErrorCode LipSyncSDK_Cancel(LipSyncSDKHandle handle,
+                                      const char *uuid) {
+  if (!handle || !uuid) {
+    return lip_sync::ErrorCode::INVALID_INPUT;
+  }
+  lip_sync::LipSyncSDK *sdk = (lip_sync::LipSyncSDK *)handle;
+  return sdk->cancel(uuid);
+}
+
+lip_sync::ErrorCode LipSyncSDK_GetStageStats(LipSyncSDKHandle handle,
+                                             lip_sync::StageStats *stats,
+                                             size_t capacity, size_t *count) {
+  if (!handle || !count || (!stats && capacity > 0)) {
+    return lip_sync::ErrorCode::INVALID_INPUT;
+  }
+  lip_sync::LipSyncSDK *sdk = (lip_sync::LipSyncSDK *)handle;
+  std::vector<lip_sync::StageStats> result;
+  auto ret = sdk->getStageStats(result);
+  if (ret != lip_sync::ErrorCode::SUCCESS) {
+    return ret;
+  }
+  *count = std::min(capacity, result.size());
+  std::copy(result.begin(), result.begin() + *count, stats);
+  return lip_sync::ErrorCode::SUCCESS;
+}
+
+LipSyncPrecomputeHandle LipSyncPrecompute_Create() {
+  lip_sync::FeaturePrecompute *precompute = new lip_sync::FeaturePrecompute();
+  return (LipSyncPrecomputeHandle)precompute;
+}
+
+void LipSyncPrecompute_Destroy(LipSyncPrecomputeHandle handle) {
+  if (handle) {
+    delete (lip_sync::FeaturePrecompute *)handle;
+  }
+}
+
+lip_sync::ErrorCode
+LipSyncPrecompute_Initialize(LipSyncPrecomputeHandle handle,
+                             const lip_sync::PrecomputeConfig *config) {
+  if (!handle || !config) {
+    return lip_sync::ErrorCode::INITIALIZATION_FAILED;
+  }
+  lip_sync::FeaturePrecompute *precompute =
+      (lip_sync::FeaturePrecompute *)handle;
+  return precompute->initialize(*config);
+}
+
+lip_sync::ErrorCode
+LipSyncPrecompute_Process(LipSyncPrecomputeHandle handle,
+                          const lip_sync::InputPacket *input,
+                          const char *featurePath) {
+  if (!handle || !input || !featurePath) {
+    return lip_sync::ErrorCode::INVALID_INPUT;
+  }
+  lip_sync::FeaturePrecompute *precompute =
+      (lip_sync::FeaturePrecompute *)handle;
+  return precompute->process(*input, featurePath);
+}
+
 const char *LipSyncSDK_GetVersion() {
   std::string version = lip_sync::LipSyncSDK::getVersion();
   char *c_version = (char *)malloc(version.length() + 1);
@@ -10,13 +10,18 @@
  */
 #include "lip_sync_sdk_impl.hpp"
 #include "audio/audio_processor.hpp"
+#include "core/model_registry.hpp"
 #include "core/types.hpp"
 #include "logger/logger.hpp"
 #include "utils/time_utils.hpp"
 #include "wav_lip_manager.hpp"
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <opencv2/core/types.hpp>
+#include <optional>
 #include <string>
+#include <thread>
 
 namespace lip_sync {
 
@@ -24,47 +29,203 @@ using namespace lip_sync::infer;
 LipSyncSDKImpl::LipSyncSDKImpl() : isRunning(false) {}
 
 ErrorCode LipSyncSDKImpl::initialize(const SDKConfig &config) {
+  // 全局线程池须在加载模型前确定，由进程内所有 SDK 实例共享
+  if (config.wavLipSession.useGlobalThreadPool ||
+      config.encoderSession.useGlobalThreadPool) {
+    dnn::ModelRegistry::ThreadPoolConfig threadPool;
+    threadPool.intraOpThreads = static_cast<int>(config.globalIntraOpThreads);
+    threadPool.interOpThreads = static_cast<int>(config.globalInterOpThreads);
+    threadPool.allowSpinning = config.globalAllowSpinning;
+    dnn::ModelRegistry::instance().setGlobalThreadPool(threadPool);
+  }
+
   WeNetConfig wenetConfig;
   wenetConfig.modelPath = config.encoderModelPath;
-  featureExtractor =
-      std::make_unique<FeatureExtractor>(FbankConfig{}, wenetConfig);
-  if (!featureExtractor->initialize()) {
-    LOGGER_ERROR("Failed to initialize feature extractor");
-    return ErrorCode::INITIALIZATION_FAILED;
+  wenetConfig.incremental = config.incrementalEncoder;
+  wenetConfig.batchSize = std::max<uint32_t>(config.encoderBatchSize, 1);
+  wenetConfig.session = toSessionConfig(config.encoderSession);
+
+  // 未配置音频编码模型时不加载编码模型，只接受预计算的特征文件
+  featureInputOnly = config.encoderModelPath.empty();
+
+  encoderModelKey = featureInputOnly
+                        ? 0
+                        : FeatureCache::modelKey(config.encoderModelPath,
+                                                 FbankConfig{}, wenetConfig);
+
+  // 音频特征缓存：以预处理后的音频与编码模型内容为键，重复的音频
+  // 不再计算特征
+  featureCache.reset();
+  if (!featureInputOnly &&
+      (config.featureCacheSize > 0 || !config.featureCacheDir.empty())) {
+    if (encoderModelKey == 0) {
+      LOGGER_WARN("Failed to read {}, feature cache disabled",
+                  config.encoderModelPath);
+    } else {
+      featureCache = std::make_unique<FeatureCache>(
+          config.featureCacheSize, config.featureCacheDir, encoderModelKey);
+    }
+  }
+
+  // 窗口编码交给共享的音频编码阶段，各会话的窗口可合并为一批
+  audioEncoderStage.reset();
+  audioEncoders.clear();
+  if (!config.incrementalEncoder && !featureInputOnly) {
+    for (uint32_t i = 0; i < std::max<uint32_t>(config.numEncoderWorkers, 1);
+         ++i) {
+      WeNetConfig encoderConfig = wenetConfig;
+      encoderConfig.replica = sessionReplica(config.encoderSession, i);
+      auto encoder =
+          std::make_unique<FeatureExtractor>(FbankConfig{}, encoderConfig);
+      if (!encoder->initialize()) {
+        LOGGER_ERROR("Failed to initialize audio encoder {}", i);
+        return ErrorCode::INITIALIZATION_FAILED;
+      }
+      audioEncoders.push_back(std::move(encoder));
+    }
+    audioEncoderStage = std::make_unique<PipelineStage<AudioEncodeTask>>(
+        "wenet", config.stageQueueCapacity);
+  }
+
+  // 每个音频特征线程独占一个特征提取器
+  audioWorkers.clear();
+  audioWorkers.resize(std::max<uint32_t>(config.numAudioWorkers, 1));
+  for (size_t i = 0; i < audioWorkers.size(); ++i) {
+    auto &worker = audioWorkers[i];
+    WeNetConfig workerConfig = wenetConfig;
+    workerConfig.replica = sessionReplica(config.encoderSession, i);
+    worker.featureExtractor =
+        std::make_unique<FeatureExtractor>(FbankConfig{}, workerConfig);
+    if (audioEncoderStage) {
+      worker.featureExtractor->setWindowEncoder(
+          [this](const std::vector<cv::Mat> &windows) {
+            return submitAudioWindows(windows);
+          });
+    }
+    if (!featureInputOnly && !worker.featureExtractor->initialize()) {
+      LOGGER_ERROR("Failed to initialize feature extractor");
+      return ErrorCode::INITIALIZATION_FAILED;
+    }
+    // 输入消息含会话控制信息，不能丢弃，DROP_OLDEST 时按 REJECT 处理
+    worker.stage = std::make_unique<PipelineStage<InputTask>>(
+        "audio-" + std::to_string(i), config.inputQueueCapacity,
+        config.overflowPolicy == OverflowPolicy::BLOCK
+            ? OverflowPolicy::BLOCK
+            : OverflowPolicy::REJECT);
   }
 
   imageCycler = std::make_unique<pipe::ImageCycler>(
       config.frameDir, config.faceInfoPath, config.maxCacheSize);
 
-  workers.start(config.numWorkers);
-  // 初始化模型实例，数量与线程数相同
+  faceProcessor =
+      std::make_unique<FaceProcessor>(config.faceSize, config.facePad);
+
+  samplesPerFrame = std::round(audioSampleRate / config.frameRate);
+
+  // 初始化模型实例，数量与推理线程数相同；各实例经模型注册表轮流共享
+  // wavLipSession.numSessions 个会话，只各自持有输入输出绑定
+  modelPool = std::make_unique<ModelPool>();
   for (int i = 0; i < config.numWorkers; ++i) {
     AlgoBase algoBase;
     algoBase.name = "wavlip-" + std::to_string(i);
     algoBase.modelPath = config.wavLipModelPath;
+    algoBase.session = toSessionConfig(config.wavLipSession);
+    algoBase.replica = sessionReplica(config.wavLipSession, i);
     auto model = std::make_unique<ModelInstance>(algoBase);
 
     if (!model->initialize()) {
       LOGGER_ERROR("Failed to initialize wav to lip model {}", i);
       return ErrorCode::INITIALIZATION_FAILED;
     }
-    modelInstances.push_back(std::move(model));
+    modelPool->add(std::move(model));
   }
 
-  isRunning.store(true);
-  inputProcessThread = std::thread(&LipSyncSDKImpl::inputProcessLoop, this);
+  inferBuffers.clear();
+  inferBuffers.resize(config.numWorkers);
+  for (auto &buffers : inferBuffers) {
+    buffers.output.setParams(WeNetOutput{});
+  }
 
-  // 启动工作线程池，每个线程执行processLoop
-  for (int i = 0; i < config.numWorkers; ++i) {
-    workers.submit([this]() { processLoop(); });
+  size_t maxBatchSize = std::max<uint32_t>(config.maxBatchSize, 1);
+  if (maxBatchSize > 1 && !modelPool->get(0)->supportsBatch()) {
+    LOGGER_WARN("Wav to lip model has a fixed batch size, batching disabled");
+    maxBatchSize = 1;
   }
 
-  faceProcessor =
-      std::make_unique<FaceProcessor>(config.faceSize, config.facePad);
+  // 帧队列只在 DROP_OLDEST 时丢帧，其余策略向上游施加背压；结束帧不会被丢弃
+  const size_t capacity = config.stageQueueCapacity;
+  const auto framePolicy = config.overflowPolicy == OverflowPolicy::DROP_OLDEST
+                               ? OverflowPolicy::DROP_OLDEST
+                               : OverflowPolicy::BLOCK;
+  auto canDrop = [](const FrameTask &task) { return !task.unit.isLastChunk; };
+  preprocessStage = std::make_unique<PipelineStage<FrameTask>>(
+      "preprocess", capacity, framePolicy, canDrop);
+  inferStage = std::make_unique<PipelineStage<FrameTask>>(
+      "infer", capacity, framePolicy, canDrop);
+  compositeStage = std::make_unique<PipelineStage<FrameTask>>(
+      "composite", capacity, framePolicy, canDrop);
+  encodeStage = std::make_unique<PipelineStage<FrameTask>>(
+      "encode", capacity, framePolicy, canDrop);
 
-  samplesPerFrame = std::round(audioSampleRate / config.frameRate);
+  overflowPolicy = config.overflowPolicy;
+  outputDropped = 0;
+  outputQueueCapacity = config.outputQueueCapacity;
+  outputQueue = std::make_unique<OutputQueue>(outputQueueCapacity);
+
+  holeTimeout = std::chrono::milliseconds(config.holeTimeoutMs);
+  holePolicy = config.holePolicy;
+  framesExpired = 0;
+  if (holeTimeout.count() == 0 &&
+      config.overflowPolicy == OverflowPolicy::DROP_OLDEST) {
+    LOGGER_WARN("Frames dropped under DROP_OLDEST leave holes that are never "
+                "expired when holeTimeoutMs is 0");
+  }
 
   isRunning.store(true);
+
+  if (holeTimeout.count() > 0) {
+    holeTimer.start(1);
+    holeTimer.submit([this]() { expireHoles(); });
+  }
+
+  // 由下游到上游依次启动各阶段
+  encodeStage->start(config.numEncodeWorkers,
+                     [this](std::vector<FrameTask> &tasks, size_t) {
+                       encodeFrames(tasks);
+                     });
+  compositeStage->start(config.numCompositeWorkers,
+                        [this](std::vector<FrameTask> &tasks, size_t) {
+                          compositeFrames(tasks);
+                        });
+  // 推理线程优先使用同序号的模型实例
+  inferStage->start(
+      config.numWorkers,
+      [this](std::vector<FrameTask> &tasks, size_t threadIndex) {
+        inferFrames(tasks, threadIndex);
+      },
+      maxBatchSize, std::chrono::milliseconds(config.maxBatchDelayMs));
+  preprocessStage->start(config.numPreprocessWorkers,
+                         [this](std::vector<FrameTask> &tasks, size_t) {
+                           preprocessFrames(tasks);
+                         });
+  if (audioEncoderStage) {
+    audioEncoderStage->start(
+        audioEncoders.size(),
+        [this](std::vector<AudioEncodeTask> &tasks, size_t threadIndex) {
+          encodeAudioWindows(tasks, threadIndex);
+        },
+        std::max<uint32_t>(config.encoderBatchSize, 1),
+        std::chrono::milliseconds(config.maxBatchDelayMs));
+  }
+  for (auto &worker : audioWorkers) {
+    worker.stage->start(1, [this, &worker](std::vector<InputTask> &tasks,
+                                           size_t) {
+      for (auto &task : tasks) {
+        processInput(worker, task);
+      }
+    });
+  }
+
   return ErrorCode::SUCCESS;
 }
 
@@ -72,8 +233,106 @@ ErrorCode LipSyncSDKImpl::startProcess(const InputPacket &input) {
   if (!isRunning) {
     return ErrorCode::INVALID_STATE;
   }
-  inputQueue.push(input);
-  return ErrorCode::SUCCESS;
+  if (featureInputOnly && input.featurePath.empty()) {
+    LOGGER_ERROR("No audio encoder, input {} needs a feature file",
+                 input.uuid);
+    return ErrorCode::INVALID_INPUT;
+  }
+  InputTask task;
+  task.type = InputTask::Type::CLIP;
+  task.uuid = input.uuid;
+  auto session = acquireSession(input.uuid);
+  if (!session) {
+    LOGGER_ERROR("Session {} is still in progress", input.uuid);
+    return ErrorCode::INVALID_STATE;
+  }
+  task.session = session;
+  task.packet = input;
+  auto ret = pushInput(std::move(task));
+  if (ret != ErrorCode::SUCCESS) {
+    releaseSession(session);
+  }
+  return ret;
+}
+
+ErrorCode LipSyncSDKImpl::beginSession(const std::string &uuid) {
+  if (!isRunning) {
+    return ErrorCode::INVALID_STATE;
+  }
+  if (featureInputOnly) {
+    LOGGER_ERROR("No audio encoder, stream session {} not supported", uuid);
+    return ErrorCode::INVALID_STATE;
+  }
+  {
+    std::lock_guard<std::mutex> lock(activeStreamsMutex);
+    if (!activeStreams.insert(uuid).second) {
+      LOGGER_ERROR("Stream session {} already exists", uuid);
+      return ErrorCode::INVALID_STATE;
+    }
+  }
+  InputTask task;
+  task.type = InputTask::Type::STREAM_BEGIN;
+  task.uuid = uuid;
+  auto session = acquireSession(uuid);
+  if (!session) {
+    LOGGER_ERROR("Session {} is still in progress", uuid);
+    std::lock_guard<std::mutex> lock(activeStreamsMutex);
+    activeStreams.erase(uuid);
+    return ErrorCode::INVALID_STATE;
+  }
+  task.session = session;
+  auto ret = pushInput(std::move(task));
+  if (ret != ErrorCode::SUCCESS) {
+    releaseSession(session);
+    std::lock_guard<std::mutex> lock(activeStreamsMutex);
+    activeStreams.erase(uuid);
+  }
+  return ret;
+}
+
+ErrorCode LipSyncSDKImpl::pushAudio(const std::string &uuid, const float *data,
+                                    size_t size) {
+  if (!isRunning) {
+    return ErrorCode::INVALID_STATE;
+  }
+  if (!data && size > 0) {
+    return ErrorCode::INVALID_INPUT;
+  }
+  {
+    std::lock_guard<std::mutex> lock(activeStreamsMutex);
+    if (activeStreams.count(uuid) == 0) {
+      LOGGER_ERROR("Stream session {} not found", uuid);
+      return ErrorCode::INVALID_STATE;
+    }
+  }
+  InputTask task;
+  task.type = InputTask::Type::STREAM_AUDIO;
+  task.uuid = uuid;
+  task.samples.assign(data, data + size);
+  return pushInput(std::move(task));
+}
+
+ErrorCode LipSyncSDKImpl::endSession(const std::string &uuid) {
+  if (!isRunning) {
+    return ErrorCode::INVALID_STATE;
+  }
+  {
+    std::lock_guard<std::mutex> lock(activeStreamsMutex);
+    if (activeStreams.erase(uuid) == 0) {
+      LOGGER_ERROR("Stream session {} not found", uuid);
+      return ErrorCode::INVALID_STATE;
+    }
+  }
+  InputTask task;
+  task.type = InputTask::Type::STREAM_END;
+  task.uuid = uuid;
+  auto ret = pushInput(std::move(task));
+  if (ret != ErrorCode::SUCCESS) {
+    // 入队失败时会话仍有效，可稍后重试
+    std::lock_guard<std::mutex> lock(activeStreamsMutex);
+    activeStreams.insert(uuid);
+  }
+  return ret;
 }
 
 ErrorCode LipSyncSDKImpl::terminate() {
@@ -81,25 +340,48 @@ ErrorCode LipSyncSDKImpl::terminate() {
     return ErrorCode::SUCCESS;
   }
 
-  // 等待输入处理线程结束
-  if (inputProcessThread.joinable()) {
-    inputProcessThread.join();
+  // 先通知所有阶段退出，避免上游阻塞在已停止的下游队列上
+  for (auto &worker : audioWorkers) {
+    worker.stage->requestStop();
+  }
+  if (audioEncoderStage) {
+    audioEncoderStage->requestStop();
   }
+  preprocessStage->requestStop();
+  inferStage->requestStop();
+  compositeStage->requestStop();
+  encodeStage->requestStop();
 
-  // 清理所有队列
-  inputQueue.clear();
-  processingQueue.clear();
-  taskQueue.clear();
-  outputQueue.clear();
+  // 唤醒等待模型实例的推理线程
+  modelPool->shutdown();
 
-  // 停止工作线程池
-  workers.stop();
+  // 等待各阶段线程结束并清理队列
+  for (auto &worker : audioWorkers) {
+    worker.stage->stop();
+    worker.streamSessions.clear();
+  }
+  if (audioEncoderStage) {
+    audioEncoderStage->stop();
+  }
+  preprocessStage->stop();
+  inferStage->stop();
+  compositeStage->stop();
+  encodeStage->stop();
+  holeTimer.stop();
+  outputQueue->clear();
+  {
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    sessions.clear();
+  }
 
   return ErrorCode::SUCCESS;
 }
 
 ErrorCode LipSyncSDKImpl::tryGetNext(OutputPacket &result) {
-  auto ret = outputQueue.wait_pop_for(std::chrono::milliseconds(100));
+  if (!outputQueue) {
+    return ErrorCode::INVALID_STATE;
+  }
+  auto ret = outputQueue->wait_pop_for(std::chrono::milliseconds(100));
   if (!ret.has_value()) {
     return ErrorCode::TRY_GET_NEXT_OVERTIME;
   }
@@ -107,169 +389,810 @@ ErrorCode LipSyncSDKImpl::tryGetNext(OutputPacket &result) {
   return ErrorCode::SUCCESS;
 }
 
-void LipSyncSDKImpl::inputProcessLoop() {
-  while (isRunning) {
-    InputPacket input;
-    auto result = inputQueue.wait_pop_for(std::chrono::milliseconds(100));
-    if (!result) {
-      continue;
+ErrorCode LipSyncSDKImpl::tryGetNextBatch(std::vector<OutputPacket> &results,
+                                          size_t maxCount,
+                                          uint32_t timeoutMs) {
+  if (!outputQueue) {
+    return ErrorCode::INVALID_STATE;
+  }
+  if (maxCount == 0) {
+    return ErrorCode::INVALID_INPUT;
+  }
+  results = outputQueue->wait_pop_batch(maxCount,
+                                        std::chrono::milliseconds(timeoutMs),
+                                        std::chrono::milliseconds(0));
+  if (results.empty()) {
+    return ErrorCode::TRY_GET_NEXT_OVERTIME;
+  }
+  return ErrorCode::SUCCESS;
+}
+
+ErrorCode LipSyncSDKImpl::setFrameCallback(FrameCallback callback) {
+  std::shared_ptr<const FrameCallback> newCallback;
+  if (callback) {
+    newCallback = std::make_shared<const FrameCallback>(std::move(callback));
+  }
+  std::lock_guard<std::mutex> lock(frameCallbackMutex);
+  frameCallback = std::move(newCallback);
+  return ErrorCode::SUCCESS;
+}
+
+ErrorCode LipSyncSDKImpl::getStageStats(std::vector<StageStats> &stats) {
+  if (!isRunning) {
+    return ErrorCode::INVALID_STATE;
+  }
+  stats.clear();
+
+  // 音频特征各分片合并为一个阶段
+  StageStats audioStats = audioWorkers.front().stage->getStats();
+  audioStats.name = "audio";
+  for (size_t i = 1; i < audioWorkers.size(); ++i) {
+    auto shardStats = audioWorkers[i].stage->getStats();
+    audioStats.numThreads += shardStats.numThreads;
+    audioStats.queueDepth += shardStats.queueDepth;
+    audioStats.queueCapacity += shardStats.queueCapacity;
+    audioStats.processed += shardStats.processed;
+    audioStats.busyTimeUs += shardStats.busyTimeUs;
+    audioStats.dropped += shardStats.dropped;
+  }
+  stats.push_back(audioStats);
+  if (audioEncoderStage) {
+    stats.push_back(audioEncoderStage->getStats());
+  }
+  stats.push_back(preprocessStage->getStats());
+  stats.push_back(inferStage->getStats());
+  stats.push_back(compositeStage->getStats());
+  stats.push_back(encodeStage->getStats());
+
+  // 重排缓冲中等待缺帧的帧，dropped 为超时跳过或补位的缺帧数量
+  StageStats reorderStats{};
+  reorderStats.name = "reorder";
+  {
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    for (const auto &[uuid, session] : sessions) {
+      std::unique_lock<std::mutex> reorderLock(session->reorderMutex,
+                                               std::try_to_lock);
+      if (reorderLock.owns_lock()) {
+        reorderStats.queueDepth += session->reorder.size();
+      }
     }
-    input = std::move(*result);
-    auto [audio, audioChunks] = input.audioData.empty()
-                                    ? processAudioInput(input.audioPath)
-                                    : processAudioInput(input.audioData);
-    storeAudio(input.uuid, std::move(audio));
+  }
+  reorderStats.dropped = framesExpired.load();
+  stats.push_back(reorderStats);
 
-    if (audioChunks.empty())
-      continue;
+  // 输出队列由调用者消费，没有处理线程
+  StageStats outputStats{};
+  outputStats.name = "output";
+  outputStats.queueDepth = outputQueue->size();
+  outputStats.queueCapacity = outputQueue->capacity();
+  outputStats.dropped = outputDropped.load();
+  stats.push_back(outputStats);
+  return ErrorCode::SUCCESS;
+}
+
+ErrorCode LipSyncSDKImpl::pushInput(InputTask &&task) {
+  // 按 uuid 分片，同一会话的消息按提交顺序处理
+  auto &worker =
+      audioWorkers[std::hash<std::string>{}(task.uuid) % audioWorkers.size()];
+  if (worker.stage->push(std::move(task))) {
+    return ErrorCode::SUCCESS;
+  }
+  return isRunning ? ErrorCode::QUEUE_FULL : ErrorCode::INVALID_STATE;
+}
+
+ErrorCode LipSyncSDKImpl::openOutputStream(const std::string &uuid) {
+  if (!isRunning) {
+    return ErrorCode::INVALID_STATE;
+  }
+  // 输出流须在会话开始前打开，处理中的帧不会切换输出目标
+  std::lock_guard<std::mutex> lock(sessionsMutex);
+  auto &session = sessions[uuid];
+  if (session) {
+    return session->stream ? ErrorCode::SUCCESS : ErrorCode::INVALID_STATE;
+  }
+  session = std::make_shared<Session>(uuid, samplesPerFrame);
+  session->stream = std::make_unique<OutputQueue>(outputQueueCapacity);
+  return ErrorCode::SUCCESS;
+}
+
+ErrorCode LipSyncSDKImpl::tryGetNext(const std::string &uuid,
+                                     OutputPacket &result) {
+  SessionPtr session;
+  {
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    auto iter = sessions.find(uuid);
+    if (iter == sessions.end() || !iter->second->stream) {
+      return ErrorCode::INVALID_STATE;
+    }
+    session = iter->second;
+  }
+
+  auto ret = session->stream->wait_pop_for(std::chrono::milliseconds(100));
+  if (!ret.has_value()) {
+    return ErrorCode::TRY_GET_NEXT_OVERTIME;
+  }
+  result = std::move(ret.value());
+
+  // 取走最后一帧即释放会话，不依赖调用方再读一次
+  if (result.isLastChunk) {
+    releaseSession(session);
+    return ErrorCode::END_OF_STREAM;
+  }
+  return ErrorCode::SUCCESS;
+}
+
+void LipSyncSDKImpl::setWindowEncoder(
+    infer::FeatureExtractor::WindowEncoder encoder) {
+  windowEncoder = std::move(encoder);
+}
+
+ErrorCode LipSyncSDKImpl::cancel(const std::string &uuid) {
+  if (!isRunning) {
+    return ErrorCode::INVALID_STATE;
+  }
+
+  SessionPtr session;
+  {
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    auto iter = sessions.find(uuid);
+    if (iter == sessions.end()) {
+      return ErrorCode::INVALID_STATE;
+    }
+    session = iter->second;
+    sessions.erase(iter);
+  }
 
-    for (size_t i = 0; i < audioChunks.size(); ++i) {
-      ProcessUnit unit;
-      unit.uuid = input.uuid;
-      unit.sequence = i;
-      unit.audioChunk = audioChunks[i];
-      unit.audioSegment = getAudioSegment(input.uuid, i);
-      unit.isLastChunk = i == audioChunks.size() - 1;
-      unit.timestamp = utils::getCurrentTimestamp();
+  // 先标记取消，处理中的任务在各阶段入口处跳过
+  session->cancelled = true;
+  {
+    std::lock_guard<std::mutex> lock(activeStreamsMutex);
+    activeStreams.erase(uuid);
+  }
+
+  // 清除各阶段队列中该会话的待处理任务
+  auto isSessionTask = [&](const auto &task) {
+    return task.session == session;
+  };
+  size_t purged = 0;
+  for (auto &worker : audioWorkers) {
+    purged += worker.stage->removeIf(
+        [&](const InputTask &task) { return task.uuid == uuid; });
+  }
+  purged += preprocessStage->removeIf(isSessionTask);
+  purged += inferStage->removeIf(isSessionTask);
+  purged += compositeStage->removeIf(isSessionTask);
+  purged += encodeStage->removeIf(isSessionTask);
+  purged += outputQueue->remove_if(
+      [&](const OutputPacket &packet) { return packet.uuid == uuid; });
 
-      auto [image, bbox] = imageCycler->getNextImage();
-      unit.faceData = faceProcessor->preProcess(
-          *image,
-          cv::Rect{bbox[0], bbox[1], bbox[2] - bbox[0], bbox[3] - bbox[1]});
+  // 会话音频立即释放，处理中的帧持有的音频段在帧丢弃时释放
+  session->audio.clear();
+  LOGGER_INFO("Session {} cancelled, {} pending tasks purged", uuid, purged);
+  return ErrorCode::SUCCESS;
+}
 
-      unit.originImage = image;
+LipSyncSDKImpl::SessionPtr
+LipSyncSDKImpl::acquireSession(const std::string &uuid) {
+  // 同一 uuid 的会话未结束前不能再次开始，否则两段输入共用重排与音频缓冲
+  std::lock_guard<std::mutex> lock(sessionsMutex);
+  auto &session = sessions[uuid];
+  if (!session) {
+    session = std::make_shared<Session>(uuid, samplesPerFrame);
+  } else if (session->started) {
+    return nullptr;
+  }
+  session->started = true;
+  return session;
+}
+
+void LipSyncSDKImpl::abortSession(const SessionPtr &session) {
+  // 已取消或最后一帧已下发的会话按原有流程结束
+  if (session->cancelled || session->lastSequence >= 0) {
+    return;
+  }
 
-      // 分配模型实例并创建任务
-      size_t modelIndex = i % modelInstances.size();
-      Task task;
-      task.unit = std::move(unit);
-      task.modelIndex = modelIndex;
-      taskQueue.push(std::move(task));
+  // 已下发的帧照常输出，之后补一个结束帧，调用者由此得知会话结束，
+  // 会话随结束帧输出释放
+  const int64_t sequence = session->numDispatched;
+  session->lastSequence = sequence;
+  OutputPacket packet;
+  packet.uuid = session->uuid;
+  packet.sequence = sequence;
+  packet.timestamp = utils::getCurrentTimestamp();
+  packet.width = faceProcessor->getInputSize();
+  packet.height = faceProcessor->getInputSize();
+  packet.sampleRate = 16000;
+  packet.channels = 1;
+  packet.isPlaceholder = true;
+  packet.isLastChunk = true;
+  pushOutput(session, std::move(packet));
+}
+
+void LipSyncSDKImpl::releaseSession(const SessionPtr &session) {
+  std::lock_guard<std::mutex> lock(sessionsMutex);
+  auto iter = sessions.find(session->uuid);
+  if (iter != sessions.end() && iter->second == session) {
+    sessions.erase(iter);
+  }
+}
+
+void LipSyncSDKImpl::processInput(AudioWorker &worker, InputTask &task) {
+  // 清理已取消的流式会话，其后续消息已在取消时移除
+  for (auto iter = worker.streamSessions.begin();
+       iter != worker.streamSessions.end();) {
+    if (iter->second.session->cancelled) {
+      iter = worker.streamSessions.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+
+  try {
+    if (task.type == InputTask::Type::CLIP) {
+      processClip(worker, task);
+    } else {
+      processStreamTask(worker, task);
+    }
+  } catch (const std::exception &e) {
+    LOGGER_ERROR("Failed to process input {}: {}", task.uuid, e.what());
+    // 处理失败的会话就此结束，流式会话之后的音频不再接受
+    SessionPtr session = task.session;
+    auto iter = worker.streamSessions.find(task.uuid);
+    if (task.type != InputTask::Type::CLIP &&
+        iter != worker.streamSessions.end()) {
+      session = iter->second.session;
+      worker.streamSessions.erase(iter);
+      std::lock_guard<std::mutex> lock(activeStreamsMutex);
+      activeStreams.erase(task.uuid);
+    }
+    if (session) {
+      abortSession(session);
     }
   }
 }
 
-void LipSyncSDKImpl::processLoop() {
-  while (isRunning) {
-    auto task = taskQueue.wait_pop_for(std::chrono::milliseconds(100));
-    if (!task) {
-      std::this_thread::yield(); // 让出CPU
-      continue;
+void LipSyncSDKImpl::processClip(AudioWorker &worker, InputTask &task) {
+  if (task.session->cancelled) {
+    return;
+  }
+
+  auto &input = task.packet;
+  std::shared_ptr<const FeatureFile> featureFile;
+  if (!input.featurePath.empty()) {
+    featureFile = FeatureFile::open(input.featurePath);
+    if (!featureFile) {
+      LOGGER_ERROR("Failed to open feature file {} for {}",
+                   input.featurePath, task.uuid);
+      abortSession(task.session);
+      return;
+    }
+
+    // 各特征须为编码输出的形状，否则拼接模型输入时越界；加载了编码模型
+    // 时特征须由同一模型与配置生成
+    const auto &features = featureFile->features();
+    const bool validShape =
+        !features.empty() &&
+        std::all_of(features.begin(), features.end(), [](const cv::Mat &f) {
+          return f.type() == CV_32F && f.rows == AudioChunk::kFeatureRows &&
+                 f.cols == AudioChunk::kFeatureCols;
+        });
+    if (!validShape ||
+        (!featureInputOnly && featureFile->modelKey() != encoderModelKey)) {
+      LOGGER_ERROR("Feature file {} for {} does not match the models",
+                   input.featurePath, task.uuid);
+      abortSession(task.session);
+      return;
     }
+  }
 
-    bool acquired = false;
-    size_t actualModelIndex = task->modelIndex;
+  // 特征文件输入未附带音频时，会话音频取自特征文件
+  std::vector<float> audio;
+  if (!input.audioData.empty()) {
+    audio = std::move(input.audioData);
+  } else if (!input.audioPath.empty() || !featureFile) {
+    audio::AudioProcessor audioProcessor;
+    audio = audioProcessor.readAudio(input.audioPath);
+  } else {
+    audio.assign(featureFile->audio(),
+                 featureFile->audio() + featureFile->numSamples());
+  }
+  if (audio.empty()) {
+    LOGGER_ERROR("No audio for {}", task.uuid);
+    abortSession(task.session);
+    return;
+  }
 
-    // 如果预期的模型实例忙，尝试其他模型实例
-    for (size_t i = 0; i < modelInstances.size(); ++i) {
-      actualModelIndex = (task->modelIndex + i) % modelInstances.size();
-      if (modelInstances[actualModelIndex]->tryAcquire()) {
-        acquired = true;
-        break;
+  int64_t sequence = 0;
+  AudioChunk heldChunk;
+  // 下发失败(队列满被拒绝或已取消)时结束会话，不再处理其余音频
+  auto dispatchChunks = [&](const std::vector<AudioChunk> &chunks) {
+    for (const auto &chunk : chunks) {
+      if (!heldChunk.empty() &&
+          !dispatchFrame(task.session, sequence++, heldChunk, false)) {
+        abortSession(task.session);
+        return false;
       }
+      heldChunk = chunk;
     }
+    return true;
+  };
+  auto dispatchLast = [&]() {
+    if (!heldChunk.empty()) {
+      dispatchFrame(task.session, sequence, heldChunk, true);
+    }
+  };
 
-    if (!acquired) {
-      // 如果所有模型都忙，将任务重新放回队列
-      taskQueue.push(std::move(*task));
-      std::this_thread::yield(); // 让出CPU
-      continue;
+  // 预计算的特征直接下发全部帧；帧特征引用文件映射中的数据，由会话
+  // 持有映射直到各帧处理完
+  auto &featureExtractor = *worker.featureExtractor;
+  if (featureFile) {
+    task.session->audio.assign(std::move(audio));
+    task.session->featureFile = featureFile;
+    if (dispatchChunks(
+            featureExtractor.convertToChunks(featureFile->features()))) {
+      dispatchLast();
+    }
+    return;
+  }
+
+  // 预处理整段音频（补首尾静音）后，输入音频直接作为会话音频，各帧
+  // 引用其中的片段
+  audio::AudioProcessor audioProcessor;
+  auto preprocessed = audioProcessor.preprocess(audio);
+  task.session->audio.assign(std::move(audio));
+
+  // 缓存命中时直接由缓存的特征下发全部帧，不再计算 fbank 与编码
+  uint64_t cacheKey = 0;
+  if (featureCache) {
+    cacheKey = featureCache->key(preprocessed);
+    if (auto features = featureCache->get(cacheKey)) {
+      if (dispatchChunks(featureExtractor.convertToChunks(*features))) {
+        dispatchLast();
+      }
+      return;
     }
+  }
 
-    auto *model = modelInstances[actualModelIndex]->get();
+  // 与流式会话相同，增量编码，音频块一旦就绪即下发，首帧延迟与音频
+  // 时长无关；之后的块加倍，一块内的窗口由各编码线程并行编码。保留
+  // 最近一块以便标记最后一帧
+  FeatureExtractor::StreamState state;
+  state.keepFeatures = featureCache != nullptr;
+  const size_t numSamples = preprocessed.size();
+  size_t blockSamples = clipBlockSamples;
+  for (size_t pos = 0; pos < numSamples; pos += blockSamples) {
+    if (pos > 0) {
+      blockSamples = std::min(blockSamples * 2, maxClipBlockSamples);
+    }
+    const size_t size = std::min(blockSamples, numSamples - pos);
+    const bool isLast = pos + size == numSamples;
+    auto chunks = featureExtractor.acceptWaveform(
+        state, {preprocessed.begin() + pos, preprocessed.begin() + pos + size});
+    if (isLast) {
+      auto rest = featureExtractor.finishStream(state);
+      chunks.insert(chunks.end(), rest.begin(), rest.end());
+    }
+    if (!dispatchChunks(chunks)) {
+      return;
+    }
+  }
+  dispatchLast();
 
-    // 执行推理
-    AlgoInput algoInput;
-    WeNetInput wenetInput;
-    wenetInput.audioFeature = task->unit.audioChunk;
-    wenetInput.image = task->unit.faceData.xData;
-    algoInput.setParams(wenetInput);
+  if (featureCache && !state.wenetFeatures.empty()) {
+    featureCache->put(cacheKey, std::move(state.wenetFeatures));
+  }
+}
+
+void LipSyncSDKImpl::processStreamTask(AudioWorker &worker,
+                                       InputTask &task) {
+  auto &streamSessions = worker.streamSessions;
+  if (task.type == InputTask::Type::STREAM_BEGIN) {
+    if (task.session->cancelled) {
+      return;
+    }
+    auto &session = streamSessions[task.uuid];
+    session = StreamSession{};
+    session.session = task.session;
+    return;
+  }
 
-    AlgoOutput algoOutput;
-    WeNetOutput wenetOutput;
-    algoOutput.setParams(wenetOutput);
+  auto iter = streamSessions.find(task.uuid);
+  if (iter == streamSessions.end()) {
+    LOGGER_ERROR("Stream session {} not found", task.uuid);
+    return;
+  }
+  auto &session = iter->second;
+  const bool isEnd = task.type == InputTask::Type::STREAM_END;
 
-    if (!model->infer(algoInput, algoOutput)) {
-      LOGGER_ERROR("Failed to run wav to lip inference");
-      continue;
+  // 与整段处理相同的预处理：首段补前置静音，结束时补尾部静音
+  audio::AudioProcessor audioProcessor;
+  auto preprocessed = audioProcessor.preprocessChunk(
+      task.samples.data(), task.samples.size(), !session.receivedAudio, isEnd);
+  session.receivedAudio = true;
+  session.receivedSamples += task.samples.size();
+  session.session->audio.append(task.samples.data(), task.samples.size());
+
+  auto &featureExtractor = *worker.featureExtractor;
+  auto chunks = featureExtractor.acceptWaveform(session.featureState,
+                                                preprocessed);
+  if (isEnd) {
+    auto rest = featureExtractor.finishStream(session.featureState);
+    chunks.insert(chunks.end(), rest.begin(), rest.end());
+  }
+  session.readyChunks.insert(session.readyChunks.end(), chunks.begin(),
+                             chunks.end());
+
+  // 帧对应的音频段到齐后才下发，结束时全部下发
+  size_t numDispatched = 0;
+  for (; numDispatched < session.readyChunks.size(); ++numDispatched) {
+    const size_t segmentEnd = (session.nextSequence + 1) * samplesPerFrame;
+    if (!isEnd && segmentEnd > session.receivedSamples) {
+      break;
+    }
+    const bool isLastChunk =
+        isEnd && numDispatched == session.readyChunks.size() - 1;
+    dispatchFrame(session.session, session.nextSequence++,
+                  session.readyChunks[numDispatched], isLastChunk);
+  }
+  session.readyChunks.erase(session.readyChunks.begin(),
+                            session.readyChunks.begin() + numDispatched);
+
+  if (isEnd) {
+    streamSessions.erase(iter);
+  }
+}
+
+std::vector<cv::Mat>
+LipSyncSDKImpl::submitAudioWindows(const std::vector<cv::Mat> &windows) {
+  std::vector<std::future<cv::Mat>> futures;
+  futures.reserve(windows.size());
+  for (const auto &window : windows) {
+    AudioEncodeTask task;
+    task.window = window;
+    task.result = std::make_shared<std::promise<cv::Mat>>();
+    futures.push_back(task.result->get_future());
+    if (!audioEncoderStage->push(std::move(task))) {
+      throw std::runtime_error("Audio encoder stage stopped");
+    }
+  }
+
+  // 停止时队列中的任务可能不再被处理，等待时检查运行状态
+  std::vector<cv::Mat> features;
+  features.reserve(windows.size());
+  for (auto &future : futures) {
+    while (future.wait_for(std::chrono::milliseconds(100)) !=
+           std::future_status::ready) {
+      if (!isRunning) {
+        throw std::runtime_error("Audio encoder stage stopped");
+      }
+    }
+    features.push_back(future.get());
+  }
+  return features;
+}
+
+void LipSyncSDKImpl::encodeAudioWindows(std::vector<AudioEncodeTask> &tasks,
+                                        size_t threadIndex) {
+  std::vector<cv::Mat> windows;
+  windows.reserve(tasks.size());
+  for (const auto &task : tasks) {
+    windows.push_back(task.window);
+  }
+
+  std::vector<cv::Mat> features;
+  try {
+    features = windowEncoder
+                   ? windowEncoder(windows)
+                   : audioEncoders[threadIndex]->encodeWindows(windows);
+  } catch (const std::exception &e) {
+    LOGGER_ERROR("Failed to encode audio windows: {}", e.what());
+    for (auto &task : tasks) {
+      task.result->set_exception(std::current_exception());
     }
+    return;
+  }
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    tasks[i].result->set_value(std::move(features[i]));
+  }
+}
+
+bool LipSyncSDKImpl::dispatchFrame(const SessionPtr &session, int64_t sequence,
+                                   const AudioChunk &audioChunk,
+                                   bool isLastChunk) {
+  if (session->cancelled) {
+    return false;
+  }
 
-    // 释放当前模型实例
-    modelInstances[actualModelIndex]->release();
+  FrameTask task;
+  task.session = session;
+  task.ticket = std::make_unique<FrameTicket>(session, sequence);
+  auto &unit = task.unit;
+  unit.uuid = session->uuid;
+  unit.sequence = sequence;
+  unit.audioChunk = audioChunk;
+  task.audio = session->audio.segment(sequence);
+  unit.isLastChunk = isLastChunk;
+  unit.timestamp = utils::getCurrentTimestamp();
+  session->numDispatched = sequence + 1;
+  if (isLastChunk) {
+    session->lastSequence = sequence;
+  }
 
-    auto *output = algoOutput.getParams<WeNetOutput>();
-    if (!output) {
-      LOGGER_ERROR("Failed to get wav to lip output");
+  // 头像帧按下发顺序分配，人脸预处理交给下一阶段
+  {
+    std::lock_guard<std::mutex> lock(imageCyclerMutex);
+    auto [image, bbox] = imageCycler->getNextImage();
+    unit.originImage = image;
+    unit.faceBox =
+        cv::Rect{bbox[0], bbox[1], bbox[2] - bbox[0], bbox[3] - bbox[1]};
+  }
+
+  return preprocessStage->push(std::move(task));
+}
+
+void LipSyncSDKImpl::preprocessFrames(std::vector<FrameTask> &tasks) {
+  for (auto &task : tasks) {
+    if (task.session->cancelled) {
       continue;
     }
+    auto &unit = task.unit;
+    unit.faceData = faceProcessor->preProcess(*unit.originImage, unit.faceBox);
+    inferStage->push(std::move(task));
+  }
+}
 
-    cv::Mat postProcessedFrame = faceProcessor->postProcess(
-        output->mel, task->unit.faceData, *task->unit.originImage);
+void LipSyncSDKImpl::inferFrames(std::vector<FrameTask> &tasks,
+                                 size_t threadIndex) {
+  // 已取消会话的帧不再占用推理
+  tasks.erase(std::remove_if(tasks.begin(), tasks.end(),
+                             [](const FrameTask &task) {
+                               return task.session->cancelled.load();
+                             }),
+              tasks.end());
+  if (tasks.empty()) {
+    return;
+  }
 
+  // 阻塞等待模型实例，离开作用域时自动归还
+  auto lease = modelPool->acquire(threadIndex);
+  if (!lease) {
+    return;
+  }
+  auto *model = lease.get();
+
+  // 执行推理，一个批次只调用一次模型，输出写入本线程的缓冲
+  auto &buffers = inferBuffers[threadIndex];
+  AlgoInput algoInput;
+  WeNetInput wenetInput;
+  packBatch(tasks, buffers, wenetInput);
+  algoInput.setParams(wenetInput);
+
+  auto &algoOutput = buffers.output;
+  // 失败批次的帧随任务销毁记为已丢失，由缺帧超时按 HolePolicy 处理
+  if (!model->infer(algoInput, algoOutput)) {
+    LOGGER_ERROR("Failed to run wav to lip inference");
+    return;
+  }
+
+  lease.reset();
+
+  auto *output = algoOutput.getParams<WeNetOutput>();
+  if (!output) {
+    LOGGER_ERROR("Failed to get wav to lip output");
+    return;
+  }
+
+  // 将批次输出拆分回各帧
+  const size_t melSize = output->mel.size() / tasks.size();
+  for (size_t b = 0; b < tasks.size(); ++b) {
+    auto &task = tasks[b];
+    task.mel.assign(output->mel.begin() + b * melSize,
+                    output->mel.begin() + (b + 1) * melSize);
+    compositeStage->push(std::move(task));
+  }
+}
+
+void LipSyncSDKImpl::compositeFrames(std::vector<FrameTask> &tasks) {
+  for (auto &task : tasks) {
+    if (task.session->cancelled) {
+      continue;
+    }
+    task.frame = faceProcessor->postProcess(task.mel, task.unit.faceData,
+                                            *task.unit.originImage);
+    encodeStage->push(std::move(task));
+  }
+}
+
+void LipSyncSDKImpl::encodeFrames(std::vector<FrameTask> &tasks) {
+  for (auto &task : tasks) {
+    if (task.session->cancelled) {
+      continue;
+    }
+    auto &unit = task.unit;
     OutputPacket outputPacket;
-    outputPacket.uuid = task->unit.uuid;
-    outputPacket.sequence = task->unit.sequence;
-    outputPacket.timestamp = task->unit.timestamp;
+    outputPacket.uuid = unit.uuid;
+    outputPacket.sequence = unit.sequence;
+    outputPacket.timestamp = unit.timestamp;
     outputPacket.width = faceProcessor->getInputSize();
     outputPacket.height = faceProcessor->getInputSize();
-    outputPacket.audioData = task->unit.audioSegment;
+    outputPacket.audioData = std::move(task.audio);
     outputPacket.sampleRate = 16000;
     outputPacket.channels = 1;
-    cv::imencode(".png", postProcessedFrame, outputPacket.frameData);
+    outputPacket.isLastChunk = unit.isLastChunk;
+    cv::imencode(".png", task.frame, outputPacket.frameData);
 
-    outputQueue.push(std::move(outputPacket));
+    task.ticket->delivered = true;
+    pushOutput(task.session, std::move(outputPacket));
   }
 }
 
-std::pair<std::vector<float>, std::vector<cv::Mat>>
-LipSyncSDKImpl::processAudioInput(const std::string &audioPath) {
-  audio::AudioProcessor audioProcessor;
-  auto audio = audioProcessor.readAudio(audioPath);
-  if (audio.empty()) {
-    return {};
+void LipSyncSDKImpl::pushOutput(const SessionPtr &session,
+                                OutputPacket &&packet) {
+  // 同一会话的帧在各阶段间可能乱序完成，重排后严格按序号输出；
+  // 顺序到达的帧直接输出，不经过缓冲
+  std::lock_guard<std::mutex> lock(session->reorderMutex);
+  const int64_t sequence = packet.sequence;
+  if (!session->reorder.push(sequence, std::move(packet),
+                             [&](OutputPacket &&ready) {
+                               deliverOutput(session, std::move(ready));
+                             })) {
+    LOGGER_WARN("Frame {} of {} arrived after its hole timeout, dropped",
+                sequence, session->uuid);
   }
 
-  auto preprocessedAudio = audioProcessor.preprocess(audio);
-  auto fbankFeatures = featureExtractor->computeFbank(preprocessedAudio);
-  auto wenetFeatures = featureExtractor->extractWenetFeatures(fbankFeatures);
-  return {audio, featureExtractor->convertToChunks(wenetFeatures)};
+  // 已输出部分的音频不再需要，仍在使用的音频段各自持有引用
+  session->audio.release(session->reorder.next());
 }
 
-std::pair<std::vector<float>, std::vector<cv::Mat>>
-LipSyncSDKImpl::processAudioInput(const std::vector<float> &audio) {
-  if (audio.empty()) {
-    return {};
-  }
+void LipSyncSDKImpl::expireHoles() {
+  const auto interval =
+      std::max(holeTimeout / 4, std::chrono::milliseconds(1));
+  while (isRunning) {
+    std::this_thread::sleep_for(interval);
 
-  audio::AudioProcessor audioProcessor;
-  auto preprocessedAudio = audioProcessor.preprocess(audio);
-  auto fbankFeatures = featureExtractor->computeFbank(preprocessedAudio);
-  auto wenetFeatures = featureExtractor->extractWenetFeatures(fbankFeatures);
-  return {audio, featureExtractor->convertToChunks(wenetFeatures)};
+    std::vector<SessionPtr> snapshot;
+    {
+      std::lock_guard<std::mutex> lock(sessionsMutex);
+      snapshot.reserve(sessions.size());
+      for (const auto &[uuid, session] : sessions) {
+        snapshot.push_back(session);
+      }
+    }
+
+    const auto now = ReorderBuffer<OutputPacket>::Clock::now();
+    for (const auto &session : snapshot) {
+      // 正在输出的会话可能阻塞在已满的输出队列上，留到下一轮检查
+      std::unique_lock<std::mutex> lock(session->reorderMutex,
+                                        std::try_to_lock);
+      if (!lock.owns_lock() || session->cancelled) {
+        continue;
+      }
+
+      // 最后一帧丢失时总是补位，作为结束帧输出，会话随之结束
+      const int64_t lastSequence = session->lastSequence;
+      auto fill = [&](int64_t sequence) -> std::optional<OutputPacket> {
+        const bool isLastChunk = sequence == lastSequence;
+        if (holePolicy == HolePolicy::SKIP && !isLastChunk) {
+          return std::nullopt;
+        }
+        OutputPacket placeholder;
+        placeholder.uuid = session->uuid;
+        placeholder.sequence = sequence;
+        placeholder.timestamp = utils::getCurrentTimestamp();
+        placeholder.width = faceProcessor->getInputSize();
+        placeholder.height = faceProcessor->getInputSize();
+        placeholder.audioData = session->audio.segment(sequence);
+        placeholder.sampleRate = 16000;
+        placeholder.channels = 1;
+        placeholder.isPlaceholder = true;
+        placeholder.isLastChunk = isLastChunk;
+        return placeholder;
+      };
+      const size_t numExpired = session->reorder.expire(
+          now, holeTimeout,
+          [&](int64_t sequence) { return session->isLost(sequence); }, fill,
+          [&](OutputPacket &&ready) {
+            deliverOutput(session, std::move(ready));
+          },
+          lastSequence);
+      session->forgetLost(session->reorder.next());
+      if (numExpired > 0) {
+        framesExpired += numExpired;
+        LOGGER_WARN("Session {}: {} missing frames timed out", session->uuid,
+                    numExpired);
+        session->audio.release(session->reorder.next());
+      }
+    }
+  }
 }
 
-void LipSyncSDKImpl::storeAudio(const std::string &uuid,
-                                std::vector<float> &&samples) {
-  std::lock_guard<std::mutex> lock(audioStorageMutex);
-  audioStorage[uuid] =
-      AudioData{std::move(samples), uuid, utils::getCurrentTimestamp()};
+void LipSyncSDKImpl::deliverOutput(const SessionPtr &session,
+                                   OutputPacket &&packet) {
+  const bool isLastChunk = packet.isLastChunk;
+
+  // 未打开输出流的会话优先交给帧回调，不经过输出队列
+  if (!session->stream) {
+    std::shared_ptr<const FrameCallback> callback;
+    {
+      std::lock_guard<std::mutex> lock(frameCallbackMutex);
+      callback = frameCallback;
+    }
+    if (callback) {
+      try {
+        (*callback)(packet);
+      } catch (const std::exception &e) {
+        LOGGER_ERROR("Frame callback failed for {}: {}", packet.uuid,
+                     e.what());
+      }
+      if (isLastChunk) {
+        releaseSession(session);
+      }
+      return;
+    }
+  }
+
+  // 打开了输出流的会话写入自己的队列，其余写入全局队列
+  auto &queue = session->stream ? *session->stream : *outputQueue;
+
+  // 实时模式下丢弃最早的帧，但保留结束帧；队列中只剩结束帧时丢弃新帧，
+  // 新帧本身是结束帧时等待
+  bool handled = false;
+  if (overflowPolicy == OverflowPolicy::DROP_OLDEST) {
+    auto result = queue.push_drop_oldest(
+        packet, [](const OutputPacket &item) { return !item.isLastChunk; });
+    if (result != utils::DropPushResult::FULL || !isLastChunk) {
+      if (result != utils::DropPushResult::PUSHED) {
+        ++outputDropped;
+      }
+      handled = true;
+    }
+  }
+
+  // 消费者过慢时阻塞编码阶段，压力逐级传回音频阶段
+  while (!handled && isRunning && !session->cancelled) {
+    handled = queue.wait_push_for(packet, std::chrono::milliseconds(100));
+  }
+
+  // 写入全局队列的会话在最后一帧输出后结束，输出流会话在最后一帧被取走时结束
+  if (isLastChunk && !session->stream) {
+    releaseSession(session);
+  }
 }
 
-std::vector<float> LipSyncSDKImpl::getAudioSegment(const std::string &uuid,
-                                                   size_t startFrame) {
-  std::lock_guard<std::mutex> lock(audioStorageMutex);
-  size_t startSample = startFrame * samplesPerFrame;
+void LipSyncSDKImpl::packBatch(const std::vector<FrameTask> &tasks,
+                               InferBuffers &buffers, WeNetInput &input) {
+  // 音频特征在此时才从各帧引用的特征块拼接，缓冲只增不减，批大小变化时
+  // 也不重新分配
+  const auto &first = tasks.front().unit;
+  const int batchSize = static_cast<int>(tasks.size());
+  const size_t audioSize = first.audioChunk.total();
+  if (buffers.audioFeature.total() < batchSize * audioSize) {
+    buffers.audioFeature.create(batchSize * audioSize, 1, CV_32F);
+  }
+  input.audioFeature = cv::Mat(batchSize * first.audioChunk.rows(),
+                               first.audioChunk.cols(), CV_32F,
+                               buffers.audioFeature.ptr<float>());
+  if (tasks.size() == 1) {
+    input.image = first.faceData.xData;
+    first.audioChunk.copyTo(input.audioFeature.ptr<float>());
+    return;
+  }
 
-  auto &audioData = audioStorage[uuid];
+  // 图像打包为 NCHW
+  const cv::Mat &image = first.faceData.xData;
+  const size_t imageSize = image.total();
+  if (buffers.image.total() < batchSize * imageSize) {
+    buffers.image.create(batchSize * imageSize, 1, CV_32F);
+  }
+  int imageDims[] = {batchSize, image.size[1], image.size[2], image.size[3]};
+  input.image = cv::Mat(4, imageDims, CV_32F, buffers.image.ptr<float>());
 
-  if (startSample >= audioData.samples.size()) {
-    // 补0返回
-    return std::vector<float>(samplesPerFrame, 0.0f);
+  for (int b = 0; b < batchSize; ++b) {
+    const auto &unit = tasks[b].unit;
+    std::memcpy(input.image.ptr<float>() + b * imageSize,
+                unit.faceData.xData.ptr<float>(), imageSize * sizeof(float));
+    unit.audioChunk.copyTo(input.audioFeature.ptr<float>() + b * audioSize);
   }
-  return std::vector<float>(
-      audioData.samples.begin() + startSample,
-      audioData.samples.begin() +
-          std::min(startSample + samplesPerFrame, audioData.samples.size()));
 }
 
 } // namespace lip_sync
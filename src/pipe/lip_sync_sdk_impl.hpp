@@ -12,76 +12,220 @@
 #ifndef __LIP_SYNC_SDK_IMPL_HPP__
 #define __LIP_SYNC_SDK_IMPL_HPP__
 
+#include "audio_buffer.hpp"
 #include "core/face_processor.hpp"
+#include "core/feature_cache.hpp"
 #include "core/feature_extractor.hpp"
+#include "core/feature_file.hpp"
 #include "core/image_cycler.hpp"
 #include "core/types.hpp"
+#include "lip_sync_sdk.hpp"
 #include "lip_sync_types.h"
-#include "utils/thread_pool.hpp"
+#include "pipeline_stage.hpp"
+#include "reorder_buffer.hpp"
 #include "utils/thread_safe_queue.hpp"
 #include "wav_lip_manager.hpp"
 #include <atomic>
+#include <future>
 #include <memory>
+#include <set>
+#include <unordered_map>
 
 namespace lip_sync {
 
 using namespace utils;
 
-struct OutputPacketComparator {
-  bool operator()(const OutputPacket &a, const OutputPacket &b) {
-    if (a.sequence == b.sequence) {
-      return a.timestamp > b.timestamp;
-    }
-    return a.sequence > b.sequence;
-  }
-};
+using OutputQueue = ThreadSafeQueue<OutputPacket>;
 
 class LipSyncSDKImpl {
 private:
-  // 第一级队列：接收输入数据
-  ThreadSafeQueue<InputPacket> inputQueue;
+  // 会话：随任务在各阶段间传递，用于取消与按会话输出
+  struct Session {
+    Session(std::string uuid, size_t samplesPerFrame)
+        : uuid(std::move(uuid)), audio(samplesPerFrame) {}
+
+    std::string uuid;
+    std::atomic<bool> cancelled{false};
+
+    // 已由 startProcess/beginSession 开始，仅打开输出流时为 false；
+    // 由 sessionsMutex 保护
+    bool started = false;
+
+    // 会话音频，随会话结束释放；帧只持有其中一段的引用
+    AudioBuffer audio;
+
+    // 特征文件输入时的文件映射，各帧的音频特征引用其中的数据
+    std::shared_ptr<const infer::FeatureFile> featureFile;
+
+    // 会话输出流，未打开时输出进入全局队列
+    std::unique_ptr<OutputQueue> stream;
+
+    // 最后一帧的序号，下发前为 -1；末尾的帧丢失时据此结束会话
+    std::atomic<int64_t> lastSequence{-1};
+
+    // 已下发的帧数，仅由所属的音频特征线程写入
+    std::atomic<int64_t> numDispatched{0};
+
+    // 未输出即被丢弃的帧(丢帧、处理失败)，缺帧超时只跳过或补位这些帧，
+    // 仍在处理中的帧总会等到
+    void markLost(int64_t sequence) {
+      std::lock_guard<std::mutex> lock(lostMutex);
+      lost.insert(sequence);
+    }
+    bool isLost(int64_t sequence) {
+      std::lock_guard<std::mutex> lock(lostMutex);
+      return lost.count(sequence) > 0;
+    }
+    // 已输出或已超时的序号不再需要记录
+    void forgetLost(int64_t before) {
+      std::lock_guard<std::mutex> lock(lostMutex);
+      lost.erase(lost.begin(), lost.lower_bound(before));
+    }
+    std::set<int64_t> lost;
+    std::mutex lostMutex;
+
+    // 编码完成的帧在此按序号重排后输出
+    ReorderBuffer<OutputPacket> reorder;
+    std::mutex reorderMutex;
+  };
+  using SessionPtr = std::shared_ptr<Session>;
+
+  // 输入任务：整段音频，或流式会话的开始/音频/结束消息
+  struct InputTask {
+    enum class Type { CLIP, STREAM_BEGIN, STREAM_AUDIO, STREAM_END };
+    Type type{Type::CLIP};
+    std::string uuid;
+    SessionPtr session;
+    InputPacket packet;         // CLIP
+    std::vector<float> samples; // STREAM_AUDIO
+  };
+
+  // 流式会话状态，仅由所属的音频特征线程访问
+  struct StreamSession {
+    SessionPtr session;
+    infer::FeatureExtractor::StreamState featureState;
+    bool receivedAudio = false;
+    size_t receivedSamples = 0;
+    int64_t nextSequence = 0;
+    std::vector<infer::AudioChunk> readyChunks;
+  };
+
+  // 音频特征阶段按 uuid 分片，同一会话始终由同一线程处理，保证帧顺序
+  struct AudioWorker {
+    std::unique_ptr<PipelineStage<InputTask>> stage;
+    std::unique_ptr<infer::FeatureExtractor> featureExtractor;
+    std::unordered_map<std::string, StreamSession> streamSessions;
+  };
+
+  // 音频编码任务：一个独立的编码窗口，结果经 promise 交还提交线程，
+  // 任务被丢弃时提交线程得到 broken_promise 异常
+  struct AudioEncodeTask {
+    cv::Mat window;
+    std::shared_ptr<std::promise<cv::Mat>> result;
+  };
+
+  // 帧在流水线中的凭据，帧未输出就被销毁(队列满丢弃、处理失败、异常)
+  // 时把序号记为已丢失
+  struct FrameTicket {
+    FrameTicket(SessionPtr session, int64_t sequence)
+        : session(std::move(session)), sequence(sequence) {}
+    ~FrameTicket() {
+      if (!delivered) {
+        session->markLost(sequence);
+      }
+    }
+    SessionPtr session;
+    int64_t sequence;
+    bool delivered = false;
+  };
 
-  // 第二级队列：特征处理后的数据
-  ThreadSafeQueue<infer::ProcessUnit> processingQueue;
+  // 帧任务，在人脸预处理之后的各阶段间传递
+  struct FrameTask {
+    infer::ProcessUnit unit;
+    SessionPtr session;
+    std::unique_ptr<FrameTicket> ticket;
+    AudioSegment audio;     // 对应的音频段
+    std::vector<float> mel; // 推理结果
+    cv::Mat frame;          // 合成结果
+  };
+
+  // 第一阶段：音频特征提取，并为每帧分配头像帧
+  std::vector<AudioWorker> audioWorkers;
+
+  // 音频编码：各音频特征线程的编码窗口在此汇合，可跨会话凑批，由多个
+  // 编码线程并行处理，每个线程独占一个编码模型实例；增量编码模式下窗口
+  // 间有依赖，由音频特征线程自行编码
+  std::unique_ptr<PipelineStage<AudioEncodeTask>> audioEncoderStage;
+  std::vector<std::unique_ptr<infer::FeatureExtractor>> audioEncoders;
+  infer::FeatureExtractor::WindowEncoder windowEncoder;
+
+  // 未配置音频编码模型，只接受特征文件输入
+  bool featureInputOnly = false;
+
+  // 编码模型与特征配置的标识，特征文件须由相同的模型与配置生成
+  uint64_t encoderModelKey = 0;
+
+  // 整段音频的特征缓存，未配置时为空
+  std::unique_ptr<infer::FeatureCache> featureCache;
 
-  // 第三级队列：优先队列，尽可能保证输出顺序
-  ThreadSafePriorityQueue<OutputPacket, OutputPacketComparator> outputQueue;
+  // 第二阶段：人脸预处理
+  std::unique_ptr<PipelineStage<FrameTask>> preprocessStage;
 
-  // 工作线程池
-  thread_pool workers;
+  // 第三阶段：推理，可跨会话凑批
+  std::unique_ptr<PipelineStage<FrameTask>> inferStage;
 
-  // 特征提取器
-  std::unique_ptr<infer::FeatureExtractor> featureExtractor;
+  // 第四阶段：贴回原图
+  std::unique_ptr<PipelineStage<FrameTask>> compositeStage;
+
+  // 第五阶段：PNG 编码
+  std::unique_ptr<PipelineStage<FrameTask>> encodeStage;
+
+  // 输出队列：各会话的帧已按序号重排，不同会话的帧交错
+  std::unique_ptr<OutputQueue> outputQueue;
+  size_t outputQueueCapacity = 0;
+  std::atomic<uint64_t> outputDropped{0};
+
+  // 帧回调，设置后未打开输出流的会话不再写入输出队列
+  std::shared_ptr<const FrameCallback> frameCallback;
+  std::mutex frameCallbackMutex;
+
+  // 队列满时的处理策略
+  OverflowPolicy overflowPolicy = OverflowPolicy::BLOCK;
+
+  // 缺帧超时检查，缺帧后没有新帧到达时也能按时跳过或补位
+  std::chrono::milliseconds holeTimeout{0};
+  HolePolicy holePolicy = HolePolicy::SKIP;
+  std::atomic<uint64_t> framesExpired{0};
+  utils::thread_pool holeTimer;
 
   // 模型实例池
-  std::vector<std::unique_ptr<ModelInstance>> modelInstances;
+  std::unique_ptr<ModelPool> modelPool;
+
+  // 推理线程各自复用的打包输入与模型输出，稳定运行时推理不再分配内存
+  struct InferBuffers {
+    cv::Mat image;
+    cv::Mat audioFeature;
+    infer::AlgoOutput output;
+  };
+  std::vector<InferBuffers> inferBuffers;
 
   // 状态控制
   std::atomic<bool> isRunning;
 
-  // 图片周期管理器
+  // 图片周期管理器，多个音频特征线程共享
   std::unique_ptr<pipe::ImageCycler> imageCycler;
+  std::mutex imageCyclerMutex;
 
   // 人脸处理器
   std::unique_ptr<infer::FaceProcessor> faceProcessor;
 
-  // 单独的输入处理线程
-  std::thread inputProcessThread;
+  // 已开始且未结束的流式会话
+  std::set<std::string> activeStreams;
+  std::mutex activeStreamsMutex;
 
-  // 线程池任务队列
-  struct Task {
-    infer::ProcessUnit unit;
-    size_t modelIndex;
-  };
-  ThreadSafeQueue<Task> taskQueue;
-
-  struct AudioData {
-    std::vector<float> samples;
-    std::string uuid;
-    int64_t timestamp;
-  };
-  std::map<std::string, AudioData> audioStorage;
-  std::mutex audioStorageMutex;
+  // 处理中或输出流未读完的会话
+  std::unordered_map<std::string, SessionPtr> sessions;
+  std::mutex sessionsMutex;
 
   // 音频采样率
   float audioSampleRate = 16000.0f;
@@ -89,6 +233,11 @@ private:
   // 每帧对应的音频采样点数
   size_t samplesPerFrame;
 
+  // 整段音频按块增量提取特征，首块 250ms 以尽快输出首帧，之后逐块
+  // 加倍，使更多窗口同时分发到各编码线程
+  const size_t clipBlockSamples = 4000;
+  const size_t maxClipBlockSamples = 64000;
+
 public:
   LipSyncSDKImpl();
   ErrorCode initialize(const SDKConfig &config);
@@ -96,19 +245,58 @@ public:
   ErrorCode terminate();
   ErrorCode tryGetNext(OutputPacket &result);
 
-private:
-  void inputProcessLoop();
-  void processLoop();
-  std::pair<std::vector<float>, std::vector<cv::Mat>>
-  processAudioInput(const std::string &audioPath);
+  // 一次加锁取出多帧，减少逐帧轮询的开销
+  ErrorCode tryGetNextBatch(std::vector<OutputPacket> &results,
+                            size_t maxCount, uint32_t timeoutMs);
 
-  std::pair<std::vector<float>, std::vector<cv::Mat>>
-  processAudioInput(const std::vector<float> &audio);
+  // 注册帧回调，传入空回调则恢复写入输出队列
+  ErrorCode setFrameCallback(FrameCallback callback);
+
+  // 流式输入：开始会话，分段推送音频，结束会话
+  ErrorCode beginSession(const std::string &uuid);
+  ErrorCode pushAudio(const std::string &uuid, const float *data, size_t size);
+  ErrorCode endSession(const std::string &uuid);
+
+  // 会话输出流：打开后该会话的帧只从 tryGetNext(uuid, ...) 获取，取到
+  // 最后一帧时返回 END_OF_STREAM 并释放会话
+  ErrorCode openOutputStream(const std::string &uuid);
+  ErrorCode tryGetNext(const std::string &uuid, OutputPacket &result);
+
+  // 取消会话，清除各阶段中该会话的待处理任务
+  ErrorCode cancel(const std::string &uuid);
+
+  // 替换音频编码阶段对编码窗口的处理，空函数恢复各编码线程的编码模型；
+  // 用于注入编码失败等情况，须在提交输入前调用，增量编码模式下不生效
+  void setWindowEncoder(infer::FeatureExtractor::WindowEncoder encoder);
+
+  // 各阶段队列深度与耗时统计
+  ErrorCode getStageStats(std::vector<StageStats> &stats);
+
+private:
+  SessionPtr acquireSession(const std::string &uuid);
+  void releaseSession(const SessionPtr &session);
+  void abortSession(const SessionPtr &session);
+  ErrorCode pushInput(InputTask &&task);
+  void pushOutput(const SessionPtr &session, OutputPacket &&packet);
+  void deliverOutput(const SessionPtr &session, OutputPacket &&packet);
+  void expireHoles();
 
-  void storeAudio(const std::string &uuid, std::vector<float> &&samples);
+  // 各阶段处理函数
+  void processInput(AudioWorker &worker, InputTask &task);
+  void processClip(AudioWorker &worker, InputTask &task);
+  void processStreamTask(AudioWorker &worker, InputTask &task);
+  std::vector<cv::Mat> submitAudioWindows(const std::vector<cv::Mat> &windows);
+  void encodeAudioWindows(std::vector<AudioEncodeTask> &tasks,
+                          size_t threadIndex);
+  bool dispatchFrame(const SessionPtr &session, int64_t sequence,
+                     const infer::AudioChunk &audioChunk, bool isLastChunk);
+  void preprocessFrames(std::vector<FrameTask> &tasks);
+  void inferFrames(std::vector<FrameTask> &tasks, size_t threadIndex);
+  void compositeFrames(std::vector<FrameTask> &tasks);
+  void encodeFrames(std::vector<FrameTask> &tasks);
 
-  std::vector<float> getAudioSegment(const std::string &uuid,
-                                     size_t startFrame);
+  void packBatch(const std::vector<FrameTask> &tasks, InferBuffers &buffers,
+                 infer::WeNetInput &input);
 };
 
 } // namespace lip_sync
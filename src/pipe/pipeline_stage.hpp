@@ -0,0 +1,168 @@
+/**
+ * @file pipeline_stage.hpp
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief 流水线阶段：有界输入队列 + 独立线程池
+ * @version 0.1
+ * @date 2024-12-25
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __PIPELINE_STAGE_HPP__
+#define __PIPELINE_STAGE_HPP__
+
+#include "lip_sync_types.h"
+#include "logger/logger.hpp"
+#include "utils/thread_pool.hpp"
+#include "utils/thread_safe_queue.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace lip_sync {
+
+template <typename T> class PipelineStage {
+public:
+  // 处理函数：一次处理从队列中取出的一批数据，threadIndex 为阶段内线程序号
+  using Handler = std::function<void(std::vector<T> &items, size_t threadIndex)>;
+
+  // 判断队列满时某个数据能否被丢弃
+  using DropFilter = std::function<bool(const T &item)>;
+
+  PipelineStage(std::string name, size_t capacity,
+                OverflowPolicy policy = OverflowPolicy::BLOCK,
+                DropFilter dropFilter = nullptr)
+      : name(std::move(name)), queue(capacity), policy(policy),
+        dropFilter(std::move(dropFilter)) {}
+
+  ~PipelineStage() { stop(); }
+
+  PipelineStage(const PipelineStage &) = delete;
+  PipelineStage &operator=(const PipelineStage &) = delete;
+
+  void start(size_t numThreads, Handler handler, size_t maxBatchSize = 1,
+             std::chrono::milliseconds maxBatchDelay = {}) {
+    this->handler = std::move(handler);
+    this->numThreads = std::max<size_t>(numThreads, 1);
+    this->maxBatchSize = std::max<size_t>(maxBatchSize, 1);
+    this->maxBatchDelay = maxBatchDelay;
+    running.store(true);
+
+    workers.start(this->numThreads);
+    for (size_t i = 0; i < this->numThreads; ++i) {
+      workers.submit([this, i]() { run(i); });
+    }
+  }
+
+  // 仅通知线程退出，不等待；用于先让上下游同时停止
+  void requestStop() { running.store(false); }
+
+  void stop() {
+    requestStop();
+    workers.stop();
+    queue.clear();
+  }
+
+  // 队列满时按策略处理：BLOCK 阻塞，REJECT 返回 false，DROP_OLDEST
+  // 丢弃最早的可丢弃数据，队列中没有可丢弃数据时丢弃可丢弃的新数据，
+  // 否则阻塞；阶段停止后返回 false
+  bool push(T value) {
+    if (!running) {
+      return false;
+    }
+
+    switch (policy) {
+    case OverflowPolicy::REJECT:
+      return queue.try_push(value);
+    case OverflowPolicy::DROP_OLDEST: {
+      auto canDrop = [this](const T &item) {
+        return !dropFilter || dropFilter(item);
+      };
+      switch (queue.push_drop_oldest(value, canDrop)) {
+      case utils::DropPushResult::PUSHED:
+        return true;
+      case utils::DropPushResult::DROPPED_OLDEST:
+        ++dropped;
+        return true;
+      default:
+        break;
+      }
+      if (canDrop(value)) {
+        ++dropped;
+        return true;
+      }
+      break;
+    }
+    default:
+      break;
+    }
+
+    while (running) {
+      if (queue.wait_push_for(value, std::chrono::milliseconds(100))) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // 从输入队列中移除满足条件的数据，返回移除数量
+  template <typename Pred> size_t removeIf(Pred pred) {
+    return queue.remove_if(pred);
+  }
+
+  StageStats getStats() const {
+    StageStats stats;
+    stats.name = name;
+    stats.numThreads = static_cast<uint32_t>(numThreads);
+    stats.queueDepth = queue.size();
+    stats.queueCapacity = queue.capacity();
+    stats.processed = processed.load();
+    stats.busyTimeUs = busyTimeUs.load();
+    stats.dropped = dropped.load();
+    return stats;
+  }
+
+private:
+  void run(size_t threadIndex) {
+    while (running) {
+      auto items = queue.wait_pop_batch(
+          maxBatchSize, std::chrono::milliseconds(100), maxBatchDelay);
+      if (items.empty()) {
+        continue;
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      try {
+        handler(items, threadIndex);
+      } catch (const std::exception &e) {
+        LOGGER_ERROR("Stage {} failed: {}", name, e.what());
+      }
+      busyTimeUs += std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+      processed += items.size();
+    }
+  }
+
+  std::string name;
+  utils::ThreadSafeQueue<T> queue;
+  const OverflowPolicy policy;
+  DropFilter dropFilter;
+  utils::thread_pool workers;
+  Handler handler;
+  size_t numThreads = 1;
+  size_t maxBatchSize = 1;
+  std::chrono::milliseconds maxBatchDelay{0};
+  std::atomic<bool> running{false};
+  std::atomic<uint64_t> processed{0};
+  std::atomic<uint64_t> busyTimeUs{0};
+  std::atomic<uint64_t> dropped{0};
+};
+
+} // namespace lip_sync
+
+#endif
@@ -0,0 +1,135 @@
+/**
+ * @file reorder_buffer.hpp
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief 单会话重排缓冲：按序号严格顺序释放帧，缺帧超时后跳过或补位
+ * @version 0.1
+ * @date 2024-12-28
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __REORDER_BUFFER_HPP__
+#define __REORDER_BUFFER_HPP__
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+namespace lip_sync {
+
+// 非线程安全，由调用者加锁
+template <typename T> class ReorderBuffer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // 放入一帧，并按序号顺序把可释放的帧交给 release(T &&)；
+  // 序号早于下一个待释放序号(已超时跳过或重复)时丢弃并返回 false
+  template <typename Release>
+  bool push(int64_t sequence, T value, Release &&release) {
+    if (sequence < nextSequence) {
+      return false;
+    }
+
+    // 顺序到达时直接释放，不经过缓冲
+    if (sequence == nextSequence && pending.empty()) {
+      ++nextSequence;
+      release(std::move(value));
+      return true;
+    }
+
+    const int64_t head = nextSequence;
+    const bool wasBlocked = numPending > 0;
+    const size_t offset = static_cast<size_t>(sequence - nextSequence);
+    if (offset >= pending.size()) {
+      pending.resize(offset + 1);
+    } else if (pending[offset].has_value()) {
+      return false;
+    }
+    pending[offset] = std::move(value);
+    ++numPending;
+    drain(release);
+    restartTimer(wasBlocked, head);
+    return true;
+  }
+
+  // 队首缺帧等待超过 timeout 时，把连续缺失且 lost(int64_t) 确认已丢失的
+  // 序号交给 fill(int64_t)：返回 std::nullopt 表示跳过，否则作为补位帧释放。
+  // 仍在处理中的帧不会被跳过，无论等待多久。last 为已知的最后一帧序号时，
+  // 末尾已丢失的帧同样处理。返回超时的缺帧数量
+  template <typename Lost, typename Fill, typename Release>
+  size_t expire(Clock::time_point now, std::chrono::milliseconds timeout,
+                Lost &&lost, Fill &&fill, Release &&release,
+                int64_t last = -1) {
+    if (numPending == 0) {
+      // 末尾缺帧之后没有帧到达，按本函数观察到的队首计时
+      if (nextSequence > last) {
+        return 0;
+      }
+      if (nextSequence != stalledHead) {
+        stalledHead = nextSequence;
+        stalledSince = now;
+        return 0;
+      }
+      if (now - stalledSince < timeout) {
+        return 0;
+      }
+    } else if (now - blockedSince < timeout) {
+      return 0;
+    }
+
+    const int64_t head = nextSequence;
+    size_t numExpired = 0;
+    while ((pending.empty() ? nextSequence <= last
+                            : !pending.front().has_value()) &&
+           lost(nextSequence)) {
+      if (auto placeholder = fill(nextSequence)) {
+        release(std::move(*placeholder));
+      }
+      if (!pending.empty()) {
+        pending.pop_front();
+      }
+      ++nextSequence;
+      ++numExpired;
+    }
+    drain(release);
+    restartTimer(true, head);
+    return numExpired;
+  }
+
+  // 已到达但等待前面缺帧的帧数量
+  size_t size() const { return numPending; }
+
+  // 下一个待释放的序号
+  int64_t next() const { return nextSequence; }
+
+private:
+  template <typename Release> void drain(Release &&release) {
+    while (!pending.empty() && pending.front().has_value()) {
+      T value = std::move(*pending.front());
+      pending.pop_front();
+      --numPending;
+      ++nextSequence;
+      release(std::move(value));
+    }
+  }
+
+  // 队首出现新的缺帧时重新计时，同一缺帧上的等待时间持续累计
+  void restartTimer(bool wasBlocked, int64_t head) {
+    if (numPending > 0 && (!wasBlocked || nextSequence != head)) {
+      blockedSince = Clock::now();
+    }
+  }
+
+  std::deque<std::optional<T>> pending; // pending[i] 对应序号 nextSequence + i
+  size_t numPending = 0;
+  int64_t nextSequence = 0;
+  Clock::time_point blockedSince{};
+  int64_t stalledHead = -1;
+  Clock::time_point stalledSince{};
+};
+
+} // namespace lip_sync
+
+#endif
@@ -14,30 +14,154 @@
 
 #include "core/types.hpp"
 #include "core/wavlip.hpp"
-#include <atomic>
+#include "lip_sync_types.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 namespace lip_sync {
+
+// 公开的会话配置转为推理模块的配置
+inline infer::SessionConfig toSessionConfig(const ModelSessionConfig &config) {
+  infer::SessionConfig session;
+  session.intraOpThreads = static_cast<int>(config.intraOpThreads);
+  session.interOpThreads = static_cast<int>(config.interOpThreads);
+  session.parallelExecution = config.parallelExecution;
+  session.allowSpinning = config.allowSpinning;
+  session.memPattern = config.memPattern;
+  session.cpuMemArena = config.cpuMemArena;
+  session.globalThreadPool = config.useGlobalThreadPool;
+  return session;
+}
+
+// 第 index 个模型实例使用的会话副本
+inline int sessionReplica(const ModelSessionConfig &config, size_t index) {
+  return static_cast<int>(index % std::max<uint32_t>(config.numSessions, 1));
+}
+
 class ModelInstance {
 public:
   ModelInstance(const infer::AlgoBase &config)
-      : model(std::make_unique<infer::dnn::WavToLipInference>(config)),
-        busy(false) {}
+      : model(std::make_unique<infer::dnn::WavToLipInference>(config)) {}
 
   bool initialize() { return model->initialize(); }
 
-  bool tryAcquire() {
-    bool expected = false;
-    return busy.compare_exchange_strong(expected, true);
+  infer::dnn::WavToLipInference *get() { return model.get(); }
+
+private:
+  std::unique_ptr<infer::dnn::WavToLipInference> model;
+};
+
+// 模型实例池：阻塞式公平借用，按 FIFO 顺序服务等待者
+class ModelPool {
+public:
+  // 借用凭证，析构时自动归还实例
+  class Lease {
+  public:
+    Lease() = default;
+    Lease(Lease &&other) noexcept
+        : pool(std::exchange(other.pool, nullptr)), index(other.index) {}
+    Lease &operator=(Lease &&other) noexcept {
+      if (this != &other) {
+        reset();
+        pool = std::exchange(other.pool, nullptr);
+        index = other.index;
+      }
+      return *this;
+    }
+    Lease(const Lease &) = delete;
+    Lease &operator=(const Lease &) = delete;
+    ~Lease() { reset(); }
+
+    explicit operator bool() const { return pool != nullptr; }
+
+    infer::dnn::WavToLipInference *get() const {
+      return pool->instances[index]->get();
+    }
+
+    size_t instanceIndex() const { return index; }
+
+    void reset() {
+      if (pool) {
+        pool->release(index);
+        pool = nullptr;
+      }
+    }
+
+  private:
+    friend class ModelPool;
+    Lease(ModelPool *pool, size_t index) : pool(pool), index(index) {}
+
+    ModelPool *pool = nullptr;
+    size_t index = 0;
+  };
+
+  void add(std::unique_ptr<ModelInstance> instance) {
+    std::lock_guard<std::mutex> lock(mutex);
+    instances.push_back(std::move(instance));
+    busy.push_back(false);
+    ++numFree;
   }
 
-  void release() { busy.store(false); }
+  size_t size() const { return instances.size(); }
 
-  infer::dnn::WavToLipInference *get() { return model.get(); }
+  infer::dnn::WavToLipInference *get(size_t index) {
+    return instances[index]->get();
+  }
+
+  // 阻塞直到轮到本次请求且有空闲实例，优先返回 preferred 实例；
+  // 池关闭后返回空凭证
+  Lease acquire(size_t preferred) {
+    std::unique_lock<std::mutex> lock(mutex);
+    const uint64_t ticket = nextTicket++;
+    cv.wait(lock, [&] {
+      return stopped || (ticket == servingTicket && numFree > 0);
+    });
+    if (stopped) {
+      return Lease();
+    }
+    ++servingTicket;
+
+    size_t index = preferred % instances.size();
+    if (busy[index]) {
+      for (index = 0; busy[index]; ++index) {
+      }
+    }
+    busy[index] = true;
+    --numFree;
+
+    // 唤醒下一个排队者
+    cv.notify_all();
+    return Lease(this, index);
+  }
+
+  // 唤醒所有等待者并拒绝后续借用
+  void shutdown() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+    cv.notify_all();
+  }
 
 private:
-  std::unique_ptr<infer::dnn::WavToLipInference> model;
-  std::atomic<bool> busy;
+  void release(size_t index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    busy[index] = false;
+    ++numFree;
+    cv.notify_all();
+  }
+
+  std::vector<std::unique_ptr<ModelInstance>> instances;
+  std::vector<bool> busy;
+  size_t numFree = 0;
+  uint64_t nextTicket = 0;
+  uint64_t servingTicket = 0;
+  bool stopped = false;
+  std::mutex mutex;
+  std::condition_variable cv;
 };
 
 } // namespace lip_sync
@@ -1,21 +1,44 @@
 #ifndef __THREAD_SAFE_QUEUE_HPP_
 #define __THREAD_SAFE_QUEUE_HPP_
 
+#include <algorithm>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <iterator>
 #include <mutex>
 #include <optional>
 #include <queue>
+#include <vector>
 
 namespace utils {
 
+// push_drop_oldest 的结果：直接入队、丢弃最早的可丢弃元素后入队、
+// 队列满且没有可丢弃元素时未入队
+enum class DropPushResult { PUSHED, DROPPED_OLDEST, FULL };
+
 template <typename T> class ThreadSafeQueue {
 public:
-  ThreadSafeQueue() = default;
+  // capacity 为 0 表示不限容量
+  explicit ThreadSafeQueue(size_t capacity = 0) : capacity_(capacity) {}
 
+  // 队列满时阻塞
   void push(T value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    queue_.push(std::move(value));
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] { return !full(); });
+    queue_.push_back(std::move(value));
+    cv_.notify_one();
+  }
+
+  // 队列满时最多等待 timeout，成功入队才会移走 value
+  bool wait_push_for(T &value, const std::chrono::milliseconds &timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!not_full_.wait_for(lock, timeout, [this] { return !full(); })) {
+      return false;
+    }
+    queue_.push_back(std::move(value));
     cv_.notify_one();
+    return true;
   }
 
   std::optional<T> try_pop() {
@@ -25,7 +48,8 @@ public:
     }
 
     T value = std::move(queue_.front());
-    queue_.pop();
+    queue_.pop_front();
+    not_full_.notify_one();
     return value;
   }
 
@@ -36,7 +60,8 @@ public:
     }
 
     T value = std::move(queue_.front());
-    queue_.pop();
+    queue_.pop_front();
+    not_full_.notify_one();
     return value;
   }
 
@@ -45,10 +70,64 @@ public:
     cv_.wait(lock, [this] { return !queue_.empty(); });
 
     T value = std::move(queue_.front());
-    queue_.pop();
+    queue_.pop_front();
+    not_full_.notify_one();
     return value;
   }
 
+  // 不等待，队列满时返回 false 且不移走 value
+  bool try_push(T &value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (full()) {
+      return false;
+    }
+    queue_.push_back(std::move(value));
+    cv_.notify_one();
+    return true;
+  }
+
+  // 队列满时丢弃最早的一个可丢弃元素后入队；没有可丢弃元素时返回 FULL
+  // 且不移走 value
+  template <typename Pred> DropPushResult push_drop_oldest(T &value,
+                                                           Pred canDrop) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto result = DropPushResult::PUSHED;
+    if (full()) {
+      auto iter = std::find_if(queue_.begin(), queue_.end(), canDrop);
+      if (iter == queue_.end()) {
+        return DropPushResult::FULL;
+      }
+      queue_.erase(iter);
+      result = DropPushResult::DROPPED_OLDEST;
+    }
+    queue_.push_back(std::move(value));
+    cv_.notify_one();
+    return result;
+  }
+
+  // 等待第一个元素最多 timeout，之后在 maxDelay 内继续收集，最多 maxCount 个
+  std::vector<T> wait_pop_batch(size_t maxCount,
+                                const std::chrono::milliseconds &timeout,
+                                const std::chrono::milliseconds &maxDelay) {
+    std::vector<T> values;
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!cv_.wait_for(lock, timeout, [this] { return !queue_.empty(); })) {
+      return values;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + maxDelay;
+    while (values.size() < maxCount) {
+      if (queue_.empty() &&
+          !cv_.wait_until(lock, deadline, [this] { return !queue_.empty(); })) {
+        break;
+      }
+      values.push_back(std::move(queue_.front()));
+      queue_.pop_front();
+    }
+    not_full_.notify_all();
+    return values;
+  }
+
   bool empty() const {
     std::lock_guard<std::mutex> lock(mutex_);
     return queue_.empty();
@@ -59,15 +138,34 @@ public:
     return queue_.size();
   }
 
+  // 移除所有满足条件的元素，返回移除数量
+  template <typename Pred> size_t remove_if(Pred pred) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = std::remove_if(queue_.begin(), queue_.end(), pred);
+    size_t removed = std::distance(iter, queue_.end());
+    queue_.erase(iter, queue_.end());
+    if (removed > 0) {
+      not_full_.notify_all();
+    }
+    return removed;
+  }
+
+  size_t capacity() const { return capacity_; }
+
   void clear() {
     std::lock_guard<std::mutex> lock(mutex_);
-    std::queue<T>().swap(queue_);
+    queue_.clear();
+    not_full_.notify_all();
   }
 
 private:
+  bool full() const { return capacity_ > 0 && queue_.size() >= capacity_; }
+
   mutable std::mutex mutex_;
-  std::queue<T> queue_;
+  std::deque<T> queue_;
   std::condition_variable cv_;
+  std::condition_variable not_full_;
+  const size_t capacity_;
 };
 
 template <typename T, typename Compare = std::less<T>>
@@ -0,0 +1,87 @@
+/**
+ * @file test_audio_buffer.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Session audio buffer: zero-copy segments and block release
+ * @version 0.1
+ * @date 2024-12-29
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "lip_sync/audio_buffer.hpp"
+#include "logger/logger.hpp"
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+using namespace lip_sync;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+int main(int argc, char **argv) {
+  const size_t samplesPerFrame = 800;
+
+  // 整段音频：音频段直接指向输入数据
+  std::vector<float> clip(samplesPerFrame * 10 + 300);
+  std::iota(clip.begin(), clip.end(), 0.0f);
+  const float *clipData = clip.data();
+  AudioBuffer clipBuffer(samplesPerFrame);
+  clipBuffer.assign(std::move(clip));
+  auto segment = clipBuffer.segment(3);
+  if (segment.data() != clipData + 3 * samplesPerFrame ||
+      segment.size() != samplesPerFrame) {
+    LOGGER_ERROR("Clip segment is not a view into the input");
+    return 1;
+  }
+  if (clipBuffer.segment(10).size() != 300 ||
+      clipBuffer.segment(11).size() != samplesPerFrame ||
+      clipBuffer.segment(11)[0] != 0.0f) {
+    LOGGER_ERROR("Unexpected tail or silence segment");
+    return 1;
+  }
+
+  // 流式音频：不对齐的推送大小，逐帧内容与整段一致
+  const size_t framesPerBlock = 4;
+  AudioBuffer streamBuffer(samplesPerFrame, framesPerBlock);
+  std::vector<float> samples(1333);
+  float next = 0.0f;
+  size_t maxHeld = 0;
+  const size_t numFrames = 1000;
+  for (size_t frame = 0; frame < numFrames;) {
+    for (auto &sample : samples) {
+      sample = next++;
+    }
+    streamBuffer.append(samples.data(), samples.size());
+    for (; (frame + 1) * samplesPerFrame <= static_cast<size_t>(next);
+         ++frame) {
+      auto view = streamBuffer.segment(frame);
+      if (view.size() != samplesPerFrame ||
+          view[0] != static_cast<float>(frame * samplesPerFrame) ||
+          view[samplesPerFrame - 1] !=
+              static_cast<float>((frame + 1) * samplesPerFrame - 1)) {
+        LOGGER_ERROR("Stream segment {} differs", frame);
+        return 1;
+      }
+      // 已输出的帧之前的块释放后，取出的音频段仍然有效
+      streamBuffer.release(frame + 1);
+      if (view[0] != static_cast<float>(frame * samplesPerFrame)) {
+        LOGGER_ERROR("Segment {} invalidated by release", frame);
+        return 1;
+      }
+    }
+    maxHeld = std::max(maxHeld, streamBuffer.heldSamples());
+  }
+
+  // 持有量由块大小决定，与会话时长无关
+  std::cout << "Stream of " << numFrames << " frames, max held samples "
+            << maxHeld << std::endl;
+  if (maxHeld > 2 * framesPerBlock * samplesPerFrame) {
+    LOGGER_ERROR("Stream audio is not released");
+    return 1;
+  }
+  return 0;
+}
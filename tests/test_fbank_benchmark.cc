@@ -0,0 +1,151 @@
+/**
+ * @file test_fbank_benchmark.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Fbank fast path against the reference implementation
+ * @version 0.1
+ * @date 2025-01-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "audio/audio_processor.hpp"
+#include "core/fbank.hpp"
+#include "core/fbank_kernels.hpp"
+#include "logger/logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace lip_sync::audio;
+using namespace lip_sync::infer;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+// Documented tolerance of the fast path: absolute on log-mel outputs of at
+// least kStrongBin of the frame's largest mel energy, and on the linear
+// energies of all bins relative to that largest one
+constexpr double kTolerance = 1e-4;
+constexpr double kStrongBin = 1e-4;
+
+// Largest log-mel difference over the strong bins and linear difference
+// over all bins, checked against kTolerance
+std::pair<double, double>
+compareFrames(const std::vector<float> &features,
+              const std::vector<std::vector<float>> &reference, int dim) {
+  double maxLogDiff = 0.0;
+  double maxLinearDiff = 0.0;
+  for (size_t i = 0; i < reference.size(); ++i) {
+    const float *frame = features.data() + i * dim;
+    const double largest =
+        *std::max_element(reference[i].begin(), reference[i].end());
+    for (int j = 0; j < dim; ++j) {
+      const double diff = std::abs(frame[j] - reference[i][j]);
+      if (reference[i][j] >= largest + std::log(kStrongBin)) {
+        maxLogDiff = std::max(maxLogDiff, diff);
+      }
+      maxLinearDiff = std::max(
+          maxLinearDiff, std::abs(std::exp(frame[j] - largest) -
+                                  std::exp(reference[i][j] - largest)));
+    }
+  }
+  return {maxLogDiff, maxLinearDiff};
+}
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  AudioProcessor audioProcessor;
+  auto audio = audioProcessor.readAudio("data/test.wav");
+  if (audio.empty()) {
+    LOGGER_ERROR("Failed to read audio");
+    return 1;
+  }
+  auto samples = audioProcessor.preprocess(audio);
+  const double seconds = samples.size() / 16000.0;
+
+  FbankComputer::FbankOptions opts;
+  opts.num_mel_bins = 80;
+  opts.dither = 0.0;
+  FbankComputer computer(opts);
+
+  // Milliseconds per second of audio, best of a few runs
+  auto measure = [&](auto &&compute) {
+    double best = 0.0;
+    for (int run = 0; run < 5; ++run) {
+      auto start = std::chrono::steady_clock::now();
+      compute();
+      std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      best = run == 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best / seconds;
+  };
+
+  std::vector<std::vector<float>> reference;
+  double referenceMs =
+      measure([&]() { reference = computer.ComputeReference(samples); });
+
+  std::vector<float> features;
+  int numFrames = 0;
+  double fastMs = measure([&]() {
+    features.clear();
+    numFrames = computer.Compute(samples.data(), samples.size(), features);
+  });
+
+  if (numFrames != static_cast<int>(reference.size())) {
+    LOGGER_ERROR("Frame count differs: {} vs {}", numFrames, reference.size());
+    return 1;
+  }
+  auto [maxLogDiff, maxLinearDiff] =
+      compareFrames(features, reference, computer.Dim());
+
+  // Gaussian noise leaves some narrow low mel bins nearly empty
+  std::mt19937 rng(0);
+  std::normal_distribution<float> noise(0.0f, 1000.0f);
+  std::vector<float> noisy(16000 * 5);
+  std::generate(noisy.begin(), noisy.end(), [&]() { return noise(rng); });
+  std::vector<float> noisyFeatures;
+  computer.Compute(noisy.data(), noisy.size(), noisyFeatures);
+  auto [noisyLogDiff, noisyLinearDiff] = compareFrames(
+      noisyFeatures, computer.ComputeReference(noisy), computer.Dim());
+  maxLogDiff = std::max(maxLogDiff, noisyLogDiff);
+  maxLinearDiff = std::max(maxLinearDiff, noisyLinearDiff);
+
+  std::cout << "Kernels: " << kernels::InstructionSet() << std::endl;
+  std::cout << "Reference: " << referenceMs << " ms per second of audio"
+            << std::endl;
+  std::cout << "Fast path: " << fastMs << " ms per second of audio ("
+            << referenceMs / fastMs << "x)" << std::endl;
+  std::cout << "Max log difference: " << maxLogDiff
+            << ", max linear difference: " << maxLinearDiff << std::endl;
+
+  // Construction with the baked tables against a configuration that builds
+  // them at run time
+  auto constructUs = [&](int numMelBins) {
+    FbankComputer::FbankOptions options = opts;
+    options.num_mel_bins = numMelBins;
+    const int numRuns = 100;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numRuns; ++i) {
+      FbankComputer fbank(options);
+    }
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / numRuns;
+  };
+  std::cout << "Construction: " << constructUs(80) << " us baked, "
+            << constructUs(81) << " us generic" << std::endl;
+
+  if (maxLogDiff > kTolerance || maxLinearDiff > kTolerance) {
+    LOGGER_ERROR("Fast path exceeds tolerance {}", kTolerance);
+    return 1;
+  }
+  return 0;
+}
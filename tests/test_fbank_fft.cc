@@ -0,0 +1,105 @@
+/**
+ * @file test_fbank_fft.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Specialized real FFT against kiss_fftr
+ * @version 0.1
+ * @date 2025-01-04
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "core/fbank_fft.hpp"
+#include "logger/logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <kiss_fftr.h>
+#include <random>
+#include <vector>
+
+using namespace lip_sync::infer;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+// Microseconds per frame, best of a few runs
+template <typename F> double measure(F &&transform, int numFrames) {
+  double best = 0.0;
+  for (int run = 0; run < 5; ++run) {
+    auto start = std::chrono::steady_clock::now();
+    transform();
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = run == 0 ? elapsed.count() : std::min(best, elapsed.count());
+  }
+  return best / numFrames;
+}
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  const int numFrames = 1000;
+  std::mt19937 rng(0);
+  std::normal_distribution<float> dist(0.0f, 1000.0f);
+
+  for (int size : {256, 512, 1024}) {
+    auto transform = fft::CreateRealFft(size);
+    if (!transform || transform->Size() != size) {
+      LOGGER_ERROR("No specialized FFT for size {}", size);
+      return 1;
+    }
+
+    std::vector<float> frames(static_cast<size_t>(numFrames) * size);
+    std::generate(frames.begin(), frames.end(), [&]() { return dist(rng); });
+
+    const int numBins = size / 2 + 1;
+    std::vector<float> single(static_cast<size_t>(numFrames) * (size + 2));
+    std::vector<kiss_fft_cpx> reference(static_cast<size_t>(numFrames) *
+                                        numBins);
+    kiss_fftr_cfg cfg = kiss_fftr_alloc(size, false, nullptr, nullptr);
+
+    double kissUs = measure(
+        [&]() {
+          for (int i = 0; i < numFrames; ++i) {
+            kiss_fftr(cfg, frames.data() + i * size,
+                      reference.data() + i * numBins);
+          }
+        },
+        numFrames);
+    double singleUs = measure(
+        [&]() {
+          for (int i = 0; i < numFrames; ++i) {
+            transform->Forward(frames.data() + i * size,
+                               single.data() + i * (size + 2));
+          }
+        },
+        numFrames);
+    kiss_fftr_free(cfg);
+
+    // Error relative to the largest magnitude of the spectrum
+    double maxDiff = 0.0;
+    double maxValue = 0.0;
+    for (int i = 0; i < numFrames; ++i) {
+      for (int k = 0; k < numBins; ++k) {
+        const auto &ref = reference[i * numBins + k];
+        const float *out = single.data() + i * (size + 2) + 2 * k;
+        maxDiff = std::max<double>(maxDiff, std::max(std::abs(out[0] - ref.r),
+                                                     std::abs(out[1] - ref.i)));
+        maxValue = std::max<double>(
+            maxValue, std::max(std::abs(ref.r), std::abs(ref.i)));
+      }
+    }
+
+    std::cout << "Size " << size << ": kiss " << kissUs << " us, split-radix "
+              << singleUs << " us per frame, relative error "
+              << maxDiff / maxValue << std::endl;
+    if (maxDiff > 1e-5 * maxValue) {
+      LOGGER_ERROR("Specialized FFT differs from kiss_fftr at size {}", size);
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file test_fbank_parallel.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Scaling of the parallel fbank Compute with the number of threads
+ * @version 0.1
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "audio/audio_processor.hpp"
+#include "core/fbank.hpp"
+#include "logger/logger.hpp"
+#include "utils/thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace lip_sync::audio;
+using namespace lip_sync::infer;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  AudioProcessor audioProcessor;
+  auto audio = audioProcessor.readAudio("data/test.wav");
+  if (audio.empty()) {
+    LOGGER_ERROR("Failed to read audio");
+    return 1;
+  }
+  auto samples = audioProcessor.preprocess(audio);
+
+  // Ten minutes of narration by repeating the test audio
+  const size_t numSamples = 10 * 60 * 16000;
+  std::vector<float> longAudio;
+  longAudio.reserve(numSamples);
+  while (longAudio.size() < numSamples) {
+    size_t size = std::min(samples.size(), numSamples - longAudio.size());
+    longAudio.insert(longAudio.end(), samples.begin(), samples.begin() + size);
+  }
+
+  // Dither on, per frame seeds must still give identical output
+  FbankComputer::FbankOptions opts;
+  opts.num_mel_bins = 80;
+  opts.dither = 1.0;
+  opts.dither_seed = 42;
+  FbankComputer computer(opts);
+
+  const size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<float> reference;
+  double baseMs = 0.0;
+  for (size_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+    utils::thread_pool pool;
+    pool.start(numThreads);
+
+    std::vector<float> features;
+    auto start = std::chrono::steady_clock::now();
+    int numFrames =
+        computer.Compute(longAudio.data(), longAudio.size(), features, pool);
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    pool.stop();
+
+    if (reference.empty()) {
+      reference = features;
+      baseMs = elapsed.count();
+    } else if (features != reference) {
+      LOGGER_ERROR("Output with {} threads differs", numThreads);
+      return 1;
+    }
+    std::cout << numThreads << " threads: " << numFrames << " frames in "
+              << elapsed.count() << " ms (" << baseMs / elapsed.count()
+              << "x)" << std::endl;
+  }
+  return 0;
+}
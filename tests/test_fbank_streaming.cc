@@ -0,0 +1,86 @@
+/**
+ * @file test_fbank_streaming.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Streaming fbank frames against batch Compute
+ * @version 0.1
+ * @date 2025-01-03
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "audio/audio_processor.hpp"
+#include "core/fbank.hpp"
+#include "logger/logger.hpp"
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace lip_sync::audio;
+using namespace lip_sync::infer;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  AudioProcessor audioProcessor;
+  auto audio = audioProcessor.readAudio("data/test.wav");
+  if (audio.empty()) {
+    LOGGER_ERROR("Failed to read audio");
+    return 1;
+  }
+  auto samples = audioProcessor.preprocess(audio);
+
+  std::mt19937 rng(0);
+  for (bool snipEdges : {true, false}) {
+    FbankComputer::FbankOptions opts;
+    opts.num_mel_bins = 80;
+    opts.dither = 0.0;
+    opts.snip_edges = snipEdges;
+    FbankComputer computer(opts);
+
+    std::vector<float> batch;
+    int numBatch = computer.Compute(samples.data(), samples.size(), batch);
+
+    // Random chunk sizes, including empty ones and ones below a frame shift.
+    // Two streams are interleaved on the same computer, the second one fed
+    // the samples of the first with a delay.
+    FbankComputer::Stream stream, delayed;
+    std::vector<float> streamed, delayedFrames;
+    int numStreamed = 0;
+    int numDelayed = 0;
+    size_t delayedPos = 0;
+    for (size_t pos = 0; pos < samples.size();) {
+      size_t size = std::min<size_t>(rng() % 2000, samples.size() - pos);
+      computer.AcceptWaveform(stream, samples.data() + pos, size);
+      pos += size;
+      numStreamed += computer.PopFrames(stream, streamed);
+
+      size_t delayedSize = (pos - delayedPos) / 2;
+      computer.AcceptWaveform(delayed, samples.data() + delayedPos,
+                              delayedSize);
+      delayedPos += delayedSize;
+      numDelayed += computer.PopFrames(delayed, delayedFrames);
+    }
+    computer.InputFinished(stream);
+    numStreamed += computer.PopFrames(stream, streamed);
+    computer.AcceptWaveform(delayed, samples.data() + delayedPos,
+                            samples.size() - delayedPos);
+    computer.InputFinished(delayed);
+    numDelayed += computer.PopFrames(delayed, delayedFrames);
+
+    std::cout << "snip_edges " << snipEdges << ": " << numBatch
+              << " batch frames, " << numStreamed << " streamed frames"
+              << std::endl;
+    if (numStreamed != numBatch || streamed != batch ||
+        numDelayed != numBatch || delayedFrames != batch) {
+      LOGGER_ERROR("Streamed frames differ from batch Compute");
+      return 1;
+    }
+  }
+  return 0;
+}
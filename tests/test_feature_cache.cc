@@ -0,0 +1,102 @@
+/**
+ * @file test_feature_cache.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Memory and disk tiers of the feature cache
+ * @version 0.1
+ * @date 2025-01-08
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "core/feature_cache.hpp"
+#include "logger/logger.hpp"
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+using namespace lip_sync::infer;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+// Features of a clip of numFeatures windows, distinct per seed
+std::vector<cv::Mat> makeFeatures(int numFeatures, float seed) {
+  std::vector<cv::Mat> features;
+  for (int i = 0; i < numFeatures; ++i) {
+    features.push_back(cv::Mat(16, 512, CV_32F, cv::Scalar(seed + i)));
+  }
+  return features;
+}
+
+bool sameFeatures(const std::vector<cv::Mat> &a,
+                  const std::vector<cv::Mat> &b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (cv::norm(a[i], b[i], cv::NORM_INF) != 0.0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  std::vector<float> clipA(16000, 0.5f);
+  std::vector<float> clipB = clipA;
+  clipB.back() = 0.25f;
+
+  // Keys depend on every sample and on the model
+  FeatureCache cache(3 * 20 * 16 * 512 * sizeof(float), "", 1);
+  FeatureCache otherModel(0, "", 2);
+  if (cache.key(clipA) == cache.key(clipB) ||
+      cache.key(clipA) != cache.key(clipA) ||
+      cache.key(clipA) == otherModel.key(clipA)) {
+    LOGGER_ERROR("Unexpected feature cache keys");
+    return 1;
+  }
+
+  // Room for three clips of 20 features, the least recently used goes
+  for (int i = 0; i < 4; ++i) {
+    cache.put(i, makeFeatures(20, i * 100.0f));
+    if (i == 2 && !cache.get(0)) {
+      LOGGER_ERROR("Clip 0 missing before eviction");
+      return 1;
+    }
+  }
+  if (!cache.get(0) || cache.get(1) || !cache.get(2) || !cache.get(3)) {
+    LOGGER_ERROR("Unexpected LRU eviction");
+    return 1;
+  }
+  if (!sameFeatures(*cache.get(3), makeFeatures(20, 300.0f))) {
+    LOGGER_ERROR("Cached features differ");
+    return 1;
+  }
+
+  // A new instance on the same directory reads the clips back from disk
+  const auto directory =
+      std::filesystem::temp_directory_path() / "lip_sync_feature_cache";
+  std::filesystem::remove_all(directory);
+  {
+    FeatureCache writer(0, directory.string(), 1);
+    writer.put(cache.key(clipA), makeFeatures(50, 1.0f));
+  }
+  FeatureCache reader(1024 * 1024 * 16, directory.string(), 1);
+  auto features = reader.get(reader.key(clipA));
+  if (!features || !sameFeatures(*features, makeFeatures(50, 1.0f))) {
+    LOGGER_ERROR("Features not read back from disk");
+    return 1;
+  }
+  if (reader.get(reader.key(clipB))) {
+    LOGGER_ERROR("Unexpected disk hit");
+    return 1;
+  }
+  std::cout << "Disk entry read back, " << reader.sizeBytes()
+            << " bytes in memory" << std::endl;
+  std::filesystem::remove_all(directory);
+  return 0;
+}
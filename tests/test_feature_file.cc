@@ -0,0 +1,144 @@
+/**
+ * @file test_feature_file.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Feature file round trip and offline precompute
+ * @version 0.1
+ * @date 2025-01-09
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "audio/audio_processor.hpp"
+#include "core/feature_extractor.hpp"
+#include "core/feature_file.hpp"
+#include "lip_sync/feature_precompute.hpp"
+#include "logger/logger.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace lip_sync;
+using namespace lip_sync::infer;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+bool sameFeatures(const std::vector<cv::Mat> &a,
+                  const std::vector<cv::Mat> &b, double tolerance) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (cv::norm(a[i], b[i], cv::NORM_INF) > tolerance) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  const auto directory =
+      std::filesystem::temp_directory_path() / "lip_sync_feature_file";
+  std::filesystem::remove_all(directory);
+  const std::string path = (directory / "clip.feat").string();
+
+  std::vector<cv::Mat> features;
+  for (int i = 0; i < 10; ++i) {
+    cv::Mat feature(16, 512, CV_32F);
+    cv::randu(feature, -1.0f, 1.0f);
+    features.push_back(feature);
+  }
+  std::vector<float> audio(12345);
+  for (size_t i = 0; i < audio.size(); ++i) {
+    audio[i] = static_cast<float>(i % 100) / 100.0f;
+  }
+  if (!FeatureFile::write(path, features, audio, 7, 9)) {
+    LOGGER_ERROR("Failed to write {}", path);
+    return 1;
+  }
+
+  // Mapped and loaded files hand out the same content
+  for (bool map : {true, false}) {
+    auto file = FeatureFile::open(path, map);
+    if (!file || file->key() != 7 || file->modelKey() != 9 ||
+        file->numSamples() != audio.size() ||
+        !sameFeatures(file->features(), features, 0.0) ||
+        !std::equal(audio.begin(), audio.end(), file->audio())) {
+      LOGGER_ERROR("Feature file differs when {}", map ? "mapped" : "loaded");
+      return 1;
+    }
+  }
+
+  // Corrupt sizes are rejected, also when they wrap once multiplied:
+  // numSamples is at byte 56 of the header, rows at byte 36
+  auto patched = [&](std::streamoff offset, const void *value, size_t size) {
+    FeatureFile::write(path, features, audio, 7, 9);
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(offset);
+    file.write(static_cast<const char *>(value), size);
+    file.close();
+    return !FeatureFile::open(path) && !FeatureFile::open(path, false);
+  };
+  const uint64_t wrappingSamples = (1ull << 62) + 1;
+  const uint32_t noRows = 0;
+  if (!patched(56, &wrappingSamples, sizeof(wrappingSamples)) ||
+      !patched(36, &noRows, sizeof(noRows))) {
+    LOGGER_ERROR("Feature file with a corrupt header accepted");
+    return 1;
+  }
+
+  // A truncated file is rejected
+  FeatureFile::write(path, features, audio, 7, 9);
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+  if (FeatureFile::open(path) || FeatureFile::open(path, false)) {
+    LOGGER_ERROR("Truncated feature file accepted");
+    return 1;
+  }
+
+  // Offline precompute gives the features of the extractor
+  PrecomputeConfig config;
+  config.encoderModelPath = "models/wenet_encoder.onnx";
+  FeaturePrecompute precompute;
+  if (precompute.initialize(config) != ErrorCode::SUCCESS) {
+    LOGGER_ERROR("Failed to initialize feature precompute");
+    return 1;
+  }
+  InputPacket input;
+  input.audioPath = "data/test.wav";
+  input.uuid = "precompute";
+  if (precompute.process(input, path) != ErrorCode::SUCCESS) {
+    LOGGER_ERROR("Failed to precompute features");
+    return 1;
+  }
+
+  WeNetConfig wenetConfig;
+  wenetConfig.modelPath = config.encoderModelPath;
+  FeatureExtractor extractor(FbankConfig{}, wenetConfig);
+  if (!extractor.initialize()) {
+    LOGGER_ERROR("Failed to initialize feature extractor");
+    return 1;
+  }
+  audio::AudioProcessor audioProcessor;
+  auto clip = audioProcessor.readAudio(input.audioPath);
+  auto reference = extractor.extractWenetFeatures(
+      extractor.computeFbank(audioProcessor.preprocess(clip)));
+
+  auto file = FeatureFile::open(path);
+  if (!file || !sameFeatures(file->features(), reference, 0.0) ||
+      file->numSamples() != clip.size()) {
+    LOGGER_ERROR("Precomputed features differ from the extractor");
+    return 1;
+  }
+  std::cout << file->features().size() << " features of "
+            << file->numSamples() << " samples in "
+            << std::filesystem::file_size(path) << " bytes" << std::endl;
+
+  std::filesystem::remove_all(directory);
+  return 0;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file test_io_binding.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Bound inference into caller owned outputs
+ * @version 0.1
+ * @date 2025-01-10
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "core/types.hpp"
+#include "core/wavlip.hpp"
+#include "core/wenet_encoder.hpp"
+#include "logger/logger.hpp"
+#include <algorithm>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+
+using namespace lip_sync::infer;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+bool sameValues(const std::vector<float> &a, const std::vector<float> &b) {
+  return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+// Runs into a kept output reuse its buffer and match a fresh output
+bool checkWavToLip(dnn::WavToLipInference &wavToLip, int batchSize) {
+  int imageDims[] = {batchSize, 6, 160, 160};
+  WeNetInput input;
+  input.image = cv::Mat(4, imageDims, CV_32F);
+  input.audioFeature = cv::Mat(batchSize * 256, 512, CV_32F);
+  cv::randu(input.image, 0.0f, 1.0f);
+  cv::randu(input.audioFeature, -1.0f, 1.0f);
+  AlgoInput algoInput;
+  algoInput.setParams(input);
+
+  AlgoOutput kept;
+  kept.setParams(WeNetOutput{});
+  const float *buffer = nullptr;
+  for (int i = 0; i < 3; ++i) {
+    if (!wavToLip.infer(algoInput, kept)) {
+      return false;
+    }
+    const auto &mel = kept.getParams<WeNetOutput>()->mel;
+    if (i > 0 && mel.data() != buffer) {
+      LOGGER_ERROR("Wav to lip output buffer reallocated in run {}", i);
+      return false;
+    }
+    buffer = mel.data();
+  }
+
+  AlgoOutput fresh;
+  fresh.setParams(WeNetOutput{});
+  return wavToLip.infer(algoInput, fresh) &&
+         sameValues(kept.getParams<WeNetOutput>()->mel,
+                    fresh.getParams<WeNetOutput>()->mel);
+}
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  AlgoBase wavToLipBase;
+  wavToLipBase.name = "wavlip";
+  wavToLipBase.modelPath = "models/w2l_with_wenet.onnx";
+  dnn::WavToLipInference wavToLip(wavToLipBase);
+  if (!wavToLip.initialize()) {
+    LOGGER_ERROR("Failed to initialize wav to lip model");
+    return 1;
+  }
+  // Batch sizes alternate as in a pipeline, each keeps its learnt shapes
+  std::vector<int> batchSizes = {1};
+  if (wavToLip.supportsBatch()) {
+    batchSizes = {1, 4, 1, 4};
+  }
+  for (int batchSize : batchSizes) {
+    if (!checkWavToLip(wavToLip, batchSize)) {
+      LOGGER_ERROR("Bound wav to lip output differs at batch {}", batchSize);
+      return 1;
+    }
+  }
+
+  AlgoBase encoderBase;
+  encoderBase.name = "wenet_encoder";
+  encoderBase.modelPath = "models/wenet_encoder.onnx";
+  dnn::WeNetEncoderInference encoder(encoderBase);
+  if (!encoder.initialize()) {
+    LOGGER_ERROR("Failed to initialize WeNet encoder");
+    return 1;
+  }
+
+  const WeNetConfig config;
+  WeNetEncoderInput input;
+  input.chunk = cv::Mat(config.framesStride * config.numFeatures, 1, CV_32F);
+  cv::randu(input.chunk, -5.0f, 5.0f);
+  input.offset = 100;
+  input.attCache = cv::Mat::zeros(3 * 8 * 16 * 128, 1, CV_32F);
+  input.cnnCache = cv::Mat::zeros(3 * 1 * 512 * 14, 1, CV_32F);
+  AlgoInput algoInput;
+  algoInput.setParams(input);
+
+  AlgoOutput kept;
+  kept.setParams(WeNetEncoderOutput{});
+  const float *buffers[3] = {};
+  for (int i = 0; i < 3; ++i) {
+    if (!encoder.infer(algoInput, kept)) {
+      LOGGER_ERROR("Failed to run WeNet encoder");
+      return 1;
+    }
+    const auto *output = kept.getParams<WeNetEncoderOutput>();
+    const float *current[3] = {output->data.data(), output->RAttCache.data(),
+                               output->RCNNCache.data()};
+    if (i > 0 && !std::equal(current, current + 3, buffers)) {
+      LOGGER_ERROR("WeNet encoder output buffers reallocated in run {}", i);
+      return 1;
+    }
+    std::copy(current, current + 3, buffers);
+  }
+
+  AlgoOutput fresh;
+  fresh.setParams(WeNetEncoderOutput{});
+  if (!encoder.infer(algoInput, fresh)) {
+    LOGGER_ERROR("Failed to run WeNet encoder");
+    return 1;
+  }
+  const auto *a = kept.getParams<WeNetEncoderOutput>();
+  const auto *b = fresh.getParams<WeNetEncoderOutput>();
+  if (!sameValues(a->data, b->data) ||
+      !sameValues(a->RAttCache, b->RAttCache) ||
+      !sameValues(a->RCNNCache, b->RCNNCache)) {
+    LOGGER_ERROR("Bound WeNet encoder output differs");
+    return 1;
+  }
+  std::cout << "Bound outputs reused, encoder output of " << a->data.size()
+            << " values" << std::endl;
+  return 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file test_lip_sync_burst.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Time to first frame when many sessions start at once
+ * @version 0.1
+ * @date 2024-12-31
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "audio/audio_processor.hpp"
+#include "lip_sync/lip_sync_sdk.hpp"
+#include "logger/logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace lip_sync;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+// 同时开始多个会话，统计各会话的首帧耗时
+bool runBenchmark(uint32_t numEncoderWorkers, const std::vector<float> &audio,
+                  int numSessions) {
+  LipSyncSDK sdk;
+  SDKConfig config;
+  config.numWorkers = 4;
+  config.numAudioWorkers = 4;
+  config.numEncoderWorkers = numEncoderWorkers;
+  config.frameDir = "data/frames";
+  config.faceInfoPath = "data/face_bboxes.json";
+  config.encoderModelPath = "models/wenet_encoder.onnx";
+  config.wavLipModelPath = "models/w2l_with_wenet.onnx";
+  config.faceSize = 160;
+  config.facePad = 4;
+  config.maxCacheSize = 1024 * 1024 * 100;
+  config.frameRate = 20;
+
+  if (sdk.initialize(config) != ErrorCode::SUCCESS) {
+    LOGGER_ERROR("Failed to initialize SDK");
+    return false;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < numSessions; ++i) {
+    InputPacket input;
+    input.audioData = audio;
+    input.uuid = "burst_" + std::to_string(i);
+    if (sdk.startProcess(input) != ErrorCode::SUCCESS) {
+      LOGGER_ERROR("Failed to start process");
+      return false;
+    }
+  }
+
+  std::map<std::string, int64_t> ttff;
+  int numLast = 0;
+  OutputPacket output;
+  while (numLast < numSessions) {
+    if (sdk.tryGetNext(output) != ErrorCode::SUCCESS) {
+      continue;
+    }
+    if (ttff.find(output.uuid) == ttff.end()) {
+      ttff[output.uuid] =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count();
+    }
+    numLast += output.isLastChunk ? 1 : 0;
+  }
+  sdk.terminate();
+
+  std::vector<int64_t> values;
+  for (const auto &[uuid, value] : ttff) {
+    values.push_back(value);
+  }
+  std::sort(values.begin(), values.end());
+  std::cout << "Encoder workers " << numEncoderWorkers << ": TTFF p50 "
+            << values[values.size() / 2] << " ms, max " << values.back()
+            << " ms" << std::endl;
+  return true;
+}
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  audio::AudioProcessor audioProcessor;
+  auto audio = audioProcessor.readAudio("data/test.wav");
+  if (audio.empty()) {
+    LOGGER_ERROR("Failed to read audio");
+    return 1;
+  }
+
+  const int numSessions = 20;
+  for (uint32_t numEncoderWorkers : {1, 2, 4}) {
+    if (!runBenchmark(numEncoderWorkers, audio, numSessions)) {
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file test_lip_sync_callback.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Output delivery latency: polling, batched pulls and frame callback
+ * @version 0.1
+ * @date 2024-12-27
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "audio/audio_processor.hpp"
+#include "lip_sync/lip_sync_sdk.hpp"
+#include "logger/logger.hpp"
+#include "utils/time_utils.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace lip_sync;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+enum class DeliveryMode { POLL, BATCH, ON_FRAME };
+
+// 同时提交多段音频，统计吞吐与帧从进入流水线到交付给调用者的平均延迟
+bool runBenchmark(DeliveryMode mode, const std::vector<float> &audio,
+                  int numSessions) {
+  LipSyncSDK sdk;
+  SDKConfig config;
+  config.numWorkers = 4;
+  config.frameDir = "data/frames";
+  config.faceInfoPath = "data/face_bboxes.json";
+  config.encoderModelPath = "models/wenet_encoder.onnx";
+  config.wavLipModelPath = "models/w2l_with_wenet.onnx";
+  config.faceSize = 160;
+  config.facePad = 4;
+  config.maxCacheSize = 1024 * 1024 * 100;
+  config.frameRate = 20;
+
+  if (sdk.initialize(config) != ErrorCode::SUCCESS) {
+    LOGGER_ERROR("Failed to initialize SDK");
+    return false;
+  }
+
+  std::mutex statsMutex;
+  int64_t totalLatency = 0;
+  int numFrames = 0;
+  std::atomic<int> numLast{0};
+  auto onFrame = [&](const OutputPacket &packet) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    totalLatency += utils::getCurrentTimestamp() - packet.timestamp;
+    numFrames++;
+    numLast += packet.isLastChunk ? 1 : 0;
+  };
+  if (mode == DeliveryMode::ON_FRAME) {
+    sdk.setFrameCallback(onFrame);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < numSessions; ++i) {
+    InputPacket input;
+    input.audioData = audio;
+    input.uuid = "session_" + std::to_string(i);
+    sdk.startProcess(input);
+  }
+
+  OutputPacket output;
+  std::vector<OutputPacket> outputs;
+  while (numLast < numSessions) {
+    switch (mode) {
+    case DeliveryMode::POLL:
+      if (sdk.tryGetNext(output) == ErrorCode::SUCCESS) {
+        onFrame(output);
+      }
+      break;
+    case DeliveryMode::BATCH:
+      if (sdk.tryGetNextBatch(outputs, 16) == ErrorCode::SUCCESS) {
+        for (const auto &packet : outputs) {
+          onFrame(packet);
+        }
+      }
+      break;
+    case DeliveryMode::ON_FRAME:
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      break;
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  sdk.terminate();
+
+  const char *names[] = {"poll", "batch", "onFrame"};
+  std::cout << names[static_cast<int>(mode)] << ": "
+            << numFrames / elapsed.count() << " frames/s, mean latency "
+            << totalLatency / std::max(numFrames, 1) << " ms" << std::endl;
+  return true;
+}
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  audio::AudioProcessor audioProcessor;
+  auto audio = audioProcessor.readAudio("data/test.wav");
+  if (audio.empty()) {
+    LOGGER_ERROR("Failed to read audio");
+    return 1;
+  }
+
+  const int numSessions = 4;
+  for (auto mode :
+       {DeliveryMode::POLL, DeliveryMode::BATCH, DeliveryMode::ON_FRAME}) {
+    if (!runBenchmark(mode, audio, numSessions)) {
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,113 @@
+/**
+ * @file test_lip_sync_failure.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief A session whose audio encoding fails still ends and frees its uuid
+ * @version 0.1
+ * @date 2025-01-10
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "audio/audio_processor.hpp"
+#include "core/feature_extractor.hpp"
+#include "lip_sync/lip_sync_sdk_impl.hpp"
+#include "logger/logger.hpp"
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+
+using namespace lip_sync;
+using namespace lip_sync::infer;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  audio::AudioProcessor audioProcessor;
+  auto audio = audioProcessor.readAudio("data/test.wav");
+  if (audio.empty()) {
+    LOGGER_ERROR("Failed to read audio");
+    return 1;
+  }
+
+  LipSyncSDKImpl sdk;
+  SDKConfig config;
+  config.numWorkers = 2;
+  config.frameDir = "data/frames";
+  config.faceInfoPath = "data/face_bboxes.json";
+  config.encoderModelPath = "models/wenet_encoder.onnx";
+  config.wavLipModelPath = "models/w2l_with_wenet.onnx";
+  config.faceSize = 160;
+  config.facePad = 4;
+  config.maxCacheSize = 1024 * 1024 * 100;
+  config.frameRate = 20;
+
+  if (sdk.initialize(config) != ErrorCode::SUCCESS) {
+    LOGGER_ERROR("Failed to initialize SDK");
+    return 1;
+  }
+
+  // 前几次编码正常，之后编码失败，模拟处理到一半的编码错误
+  WeNetConfig wenetConfig;
+  wenetConfig.modelPath = config.encoderModelPath;
+  FeatureExtractor encoder(FbankConfig{}, wenetConfig);
+  if (!encoder.initialize()) {
+    LOGGER_ERROR("Failed to initialize feature extractor");
+    return 1;
+  }
+  std::atomic<int> numRuns{0};
+  sdk.setWindowEncoder([&](const std::vector<cv::Mat> &windows) {
+    if (++numRuns > 3) {
+      throw std::runtime_error("Injected encoder failure");
+    }
+    return encoder.encodeWindows(windows);
+  });
+
+  const std::string uuid = "failing";
+  sdk.openOutputStream(uuid);
+  InputPacket input;
+  input.audioData = audio;
+  input.uuid = uuid;
+  if (sdk.startProcess(input) != ErrorCode::SUCCESS) {
+    LOGGER_ERROR("Failed to start processing");
+    return 1;
+  }
+
+  // 失败前下发的帧按序输出，最后是补位的结束帧，随结束标记一起返回
+  OutputPacket output;
+  int64_t expected = 0;
+  while (true) {
+    auto ret = sdk.tryGetNext(uuid, output);
+    if (ret == ErrorCode::TRY_GET_NEXT_OVERTIME) {
+      continue;
+    }
+    if ((ret != ErrorCode::SUCCESS && ret != ErrorCode::END_OF_STREAM) ||
+        output.sequence != expected++) {
+      LOGGER_ERROR("Unexpected output of the failed session");
+      return 1;
+    }
+    if (ret == ErrorCode::END_OF_STREAM) {
+      break;
+    }
+  }
+  if (!output.isLastChunk || !output.isPlaceholder) {
+    LOGGER_ERROR("Failed session did not end with a placeholder");
+    return 1;
+  }
+
+  // 会话结束后同一 uuid 可以再次开始
+  sdk.setWindowEncoder(nullptr);
+  if (sdk.startProcess(input) != ErrorCode::SUCCESS) {
+    LOGGER_ERROR("uuid of the failed session was not released");
+    return 1;
+  }
+  std::cout << "Failed session ended after " << expected - 1 << " frames"
+            << std::endl;
+
+  sdk.terminate();
+  return 0;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file test_lip_sync_holes.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Slow stages longer than the hole timeout lose no frames
+ * @version 0.1
+ * @date 2025-01-10
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "audio/audio_processor.hpp"
+#include "lip_sync/lip_sync_sdk.hpp"
+#include "logger/logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace lip_sync;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  audio::AudioProcessor audioProcessor;
+  auto audio = audioProcessor.readAudio("data/test.wav");
+  if (audio.empty()) {
+    LOGGER_ERROR("Failed to read audio");
+    return 1;
+  }
+  // 短音频：最后一帧在首帧输出之前就已下发
+  audio.resize(std::min<size_t>(audio.size(), 16000 * 2));
+
+  LipSyncSDK sdk;
+  SDKConfig config;
+  config.numWorkers = 2;
+  config.numEncodeWorkers = 2;
+  config.frameDir = "data/frames";
+  config.faceInfoPath = "data/face_bboxes.json";
+  config.encoderModelPath = "models/wenet_encoder.onnx";
+  config.wavLipModelPath = "models/w2l_with_wenet.onnx";
+  config.faceSize = 160;
+  config.facePad = 4;
+  config.maxCacheSize = 1024 * 1024 * 100;
+  config.frameRate = 20;
+  config.holeTimeoutMs = 20;
+  config.holePolicy = HolePolicy::SKIP;
+
+  if (sdk.initialize(config) != ErrorCode::SUCCESS) {
+    LOGGER_ERROR("Failed to initialize SDK");
+    return 1;
+  }
+
+  // 回调中每隔几帧停顿数倍于缺帧超时的时间，输出在此期间停止前进
+  std::mutex framesMutex;
+  std::vector<OutputPacket> frames;
+  std::atomic<bool> finished{false};
+  sdk.setFrameCallback([&](const OutputPacket &packet) {
+    if (packet.sequence % 8 == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    std::lock_guard<std::mutex> lock(framesMutex);
+    frames.push_back(packet);
+    if (packet.isLastChunk) {
+      finished = true;
+    }
+  });
+
+  InputPacket input;
+  input.audioData = audio;
+  input.uuid = "slow";
+  if (sdk.startProcess(input) != ErrorCode::SUCCESS) {
+    LOGGER_ERROR("Failed to start processing");
+    return 1;
+  }
+  while (!finished) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  sdk.terminate();
+
+  // 每一帧都按序输出，没有被跳过或补位的帧
+  for (size_t i = 0; i < frames.size(); ++i) {
+    if (frames[i].sequence != static_cast<int64_t>(i) ||
+        frames[i].isPlaceholder || frames[i].frameData.empty()) {
+      LOGGER_ERROR("Frame {} was skipped or replaced", i);
+      return 1;
+    }
+  }
+  std::cout << frames.size() << " frames delivered through slow stages"
+            << std::endl;
+  return 0;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file test_lip_sync_session.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Per-session output streams and cancellation
+ * @version 0.1
+ * @date 2024-12-26
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "audio/audio_processor.hpp"
+#include "lip_sync/lip_sync_sdk.hpp"
+#include "logger/logger.hpp"
+#include <iostream>
+
+using namespace lip_sync;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  audio::AudioProcessor audioProcessor;
+  auto audio = audioProcessor.readAudio("data/test.wav");
+  if (audio.empty()) {
+    LOGGER_ERROR("Failed to read audio");
+    return 1;
+  }
+
+  LipSyncSDK sdk;
+  SDKConfig config;
+  config.numWorkers = 2;
+  config.frameDir = "data/frames";
+  config.faceInfoPath = "data/face_bboxes.json";
+  config.encoderModelPath = "models/wenet_encoder.onnx";
+  config.wavLipModelPath = "models/w2l_with_wenet.onnx";
+  config.faceSize = 160;
+  config.facePad = 4;
+  config.maxCacheSize = 1024 * 1024 * 100;
+  config.frameRate = 20;
+
+  if (sdk.initialize(config) != ErrorCode::SUCCESS) {
+    LOGGER_ERROR("Failed to initialize SDK");
+    return 1;
+  }
+
+  // 两个会话各自打开输出流，其中一个处理几帧后取消
+  const std::string keepUuid = "keep";
+  const std::string cancelUuid = "cancel";
+  for (const auto &uuid : {keepUuid, cancelUuid}) {
+    sdk.openOutputStream(uuid);
+    InputPacket input;
+    input.audioData = audio;
+    input.uuid = uuid;
+    sdk.startProcess(input);
+  }
+
+  OutputPacket output;
+  int numCancelledFrames = 0;
+  while (numCancelledFrames < 3) {
+    if (sdk.tryGetNext(cancelUuid, output) == ErrorCode::SUCCESS) {
+      numCancelledFrames++;
+    }
+  }
+  if (sdk.cancel(cancelUuid) != ErrorCode::SUCCESS) {
+    LOGGER_ERROR("Failed to cancel session");
+    return 1;
+  }
+  if (sdk.tryGetNext(cancelUuid, output) != ErrorCode::INVALID_STATE) {
+    LOGGER_ERROR("Cancelled session still readable");
+    return 1;
+  }
+
+  // 保留的会话读到最后一帧为止，帧不会进入全局队列
+  int numFrames = 0;
+  while (true) {
+    auto ret = sdk.tryGetNext(keepUuid, output);
+    if (ret == ErrorCode::END_OF_STREAM) {
+      numFrames++;
+      break;
+    }
+    if (ret == ErrorCode::SUCCESS) {
+      numFrames++;
+    }
+  }
+  if (!output.isLastChunk) {
+    LOGGER_ERROR("End of stream without the last frame");
+    return 1;
+  }
+
+  // 取到最后一帧时会话已释放
+  if (sdk.tryGetNext(keepUuid, output) != ErrorCode::INVALID_STATE) {
+    LOGGER_ERROR("Session still open after its last frame was read");
+    return 1;
+  }
+  std::cout << "Session " << keepUuid << ": " << numFrames << " frames"
+            << std::endl;
+
+  if (sdk.tryGetNext(output) != ErrorCode::TRY_GET_NEXT_OVERTIME) {
+    LOGGER_ERROR("Unexpected frame in the global queue from {}", output.uuid);
+    return 1;
+  }
+
+  sdk.terminate();
+  return 0;
+}
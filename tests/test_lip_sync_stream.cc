@@ -0,0 +1,156 @@
+/**
+ * @file test_lip_sync_stream.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-12-20
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "audio/audio_processor.hpp"
+#include "core/feature_extractor.hpp"
+#include "lip_sync/lip_sync_sdk.hpp"
+#include "logger/logger.hpp"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+
+namespace fs = std::filesystem;
+using namespace lip_sync::audio;
+using namespace lip_sync::infer;
+using namespace lip_sync;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+// 流式特征与整段特征逐块比较
+bool checkStreamingFeatures(const std::vector<float> &audio,
+                            const std::string &encoderPath,
+                            size_t samplesPerPush) {
+  WeNetConfig wenetConfig;
+  wenetConfig.modelPath = encoderPath;
+  FeatureExtractor featureExtractor(FbankConfig{}, wenetConfig);
+  if (!featureExtractor.initialize()) {
+    LOGGER_ERROR("Failed to initialize feature extractor");
+    return false;
+  }
+
+  AudioProcessor audioProcessor;
+  auto fbank = featureExtractor.computeFbank(audioProcessor.preprocess(audio));
+  auto batchChunks = featureExtractor.convertToChunks(
+      featureExtractor.extractWenetFeatures(fbank));
+
+  FeatureExtractor::StreamState state;
+  std::vector<AudioChunk> streamChunks;
+  for (size_t pos = 0; pos < audio.size(); pos += samplesPerPush) {
+    size_t size = std::min(samplesPerPush, audio.size() - pos);
+    auto samples = audioProcessor.preprocessChunk(
+        audio.data() + pos, size, pos == 0, pos + size == audio.size());
+    auto chunks = featureExtractor.acceptWaveform(state, samples);
+    streamChunks.insert(streamChunks.end(), chunks.begin(), chunks.end());
+  }
+  auto rest = featureExtractor.finishStream(state);
+  streamChunks.insert(streamChunks.end(), rest.begin(), rest.end());
+
+  if (batchChunks.size() != streamChunks.size()) {
+    std::cerr << "Chunk count mismatch: batch " << batchChunks.size()
+              << ", stream " << streamChunks.size() << std::endl;
+    return false;
+  }
+
+  double maxDiff = 0.0;
+  for (size_t i = 0; i < batchChunks.size(); ++i) {
+    maxDiff = std::max(maxDiff, cv::norm(batchChunks[i].toMat(),
+                                         streamChunks[i].toMat(),
+                                         cv::NORM_INF));
+  }
+  std::cout << "Push size " << samplesPerPush << ": " << streamChunks.size()
+            << " chunks, max abs diff " << maxDiff << std::endl;
+  return maxDiff == 0.0;
+}
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  fs::path dataDir = fs::path("data");
+  fs::path audioPath = dataDir / "test.wav";
+  fs::path modelDir = fs::path("models");
+
+  AudioProcessor audioProcessor;
+  auto audio = audioProcessor.readAudio(audioPath.string());
+  if (audio.empty()) {
+    LOGGER_ERROR("Failed to read audio");
+    return 1;
+  }
+
+  for (size_t samplesPerPush : {160, 1600, 3333}) {
+    if (!checkStreamingFeatures(
+            audio, (modelDir / "wenet_encoder.onnx").string(),
+            samplesPerPush)) {
+      LOGGER_ERROR("Streaming features differ from batch features");
+      return 1;
+    }
+  }
+
+  lip_sync::LipSyncSDK sdk;
+  lip_sync::SDKConfig config;
+  config.numWorkers = 2;
+  config.frameDir = (dataDir / "frames").string();
+  config.faceInfoPath = (dataDir / "face_bboxes.json").string();
+  config.encoderModelPath = (modelDir / "wenet_encoder.onnx").string();
+  config.wavLipModelPath = (modelDir / "w2l_with_wenet.onnx").string();
+  config.faceSize = 160;
+  config.facePad = 4;
+  config.maxCacheSize = 1024 * 1024 * 100;
+  config.frameRate = 20;
+
+  if (sdk.initialize(config) != ErrorCode::SUCCESS) {
+    LOGGER_ERROR("Failed to initialize SDK");
+    return 1;
+  }
+
+  // 以 100ms 为单位模拟实时推送
+  const std::string uuid = "stream_test";
+  const size_t samplesPerPush = 1600;
+  auto start = std::chrono::steady_clock::now();
+  sdk.beginSession(uuid);
+  for (size_t pos = 0; pos < audio.size(); pos += samplesPerPush) {
+    size_t size = std::min(samplesPerPush, audio.size() - pos);
+    sdk.pushAudio(uuid, audio.data() + pos, size);
+  }
+  sdk.endSession(uuid);
+
+  int numFrames = 0;
+  bool gotLast = false;
+  OutputPacket output;
+  while (true) {
+    auto ret = sdk.tryGetNext(output);
+    if (ret == ErrorCode::TRY_GET_NEXT_OVERTIME) {
+      // 最后一帧之后不再有输出
+      if (gotLast) {
+        break;
+      }
+      continue;
+    }
+    if (numFrames == 0) {
+      auto ttff = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+      std::cout << "Time to first frame: " << ttff << " ms" << std::endl;
+    }
+    numFrames++;
+    gotLast = gotLast || output.isLastChunk;
+  }
+  auto total = std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+  std::cout << "Stream frames: " << numFrames << ", total " << total << " ms"
+            << std::endl;
+
+  sdk.terminate();
+  return 0;
+}
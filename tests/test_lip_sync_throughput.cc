@@ -0,0 +1,106 @@
+/**
+ * @file test_lip_sync_throughput.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief SDK frames/s and per-frame latency under concurrent sessions
+ * @version 0.1
+ * @date 2024-12-24
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "audio/audio_processor.hpp"
+#include "lip_sync/lip_sync_sdk.hpp"
+#include "logger/logger.hpp"
+#include "utils/time_utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace lip_sync;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+// 同时提交多段音频，统计吞吐与帧延迟(从进入推理队列到取出)
+bool runBenchmark(uint32_t numWorkers, const std::vector<float> &audio,
+                  int numSessions) {
+  LipSyncSDK sdk;
+  SDKConfig config;
+  config.numWorkers = numWorkers;
+  config.frameDir = "data/frames";
+  config.faceInfoPath = "data/face_bboxes.json";
+  config.encoderModelPath = "models/wenet_encoder.onnx";
+  config.wavLipModelPath = "models/w2l_with_wenet.onnx";
+  config.faceSize = 160;
+  config.facePad = 4;
+  config.maxCacheSize = 1024 * 1024 * 100;
+  config.frameRate = 20;
+
+  if (sdk.initialize(config) != ErrorCode::SUCCESS) {
+    LOGGER_ERROR("Failed to initialize SDK");
+    return false;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < numSessions; ++i) {
+    InputPacket input;
+    input.audioData = audio;
+    input.uuid = "session_" + std::to_string(i);
+    sdk.startProcess(input);
+  }
+
+  std::vector<int64_t> latencies;
+  int numLast = 0;
+  OutputPacket output;
+  while (numLast < numSessions) {
+    if (sdk.tryGetNext(output) != ErrorCode::SUCCESS) {
+      continue;
+    }
+    latencies.push_back(utils::getCurrentTimestamp() - output.timestamp);
+    numLast += output.isLastChunk ? 1 : 0;
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  // 各阶段耗时，用于分配各阶段线程数
+  std::vector<StageStats> stageStats;
+  sdk.getStageStats(stageStats);
+  sdk.terminate();
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) {
+    return latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+  };
+  std::cout << "Workers " << numWorkers << ": "
+            << latencies.size() / elapsed.count() << " frames/s, p50 "
+            << percentile(0.5) << " ms, p99 " << percentile(0.99) << " ms"
+            << std::endl;
+  for (const auto &stats : stageStats) {
+    std::cout << "  " << stats.name << ": threads " << stats.numThreads
+              << ", processed " << stats.processed << ", busy "
+              << stats.busyTimeUs / 1000 << " ms" << std::endl;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  audio::AudioProcessor audioProcessor;
+  auto audio = audioProcessor.readAudio("data/test.wav");
+  if (audio.empty()) {
+    LOGGER_ERROR("Failed to read audio");
+    return 1;
+  }
+
+  const int numSessions = 4;
+  for (uint32_t numWorkers : {4, 8, 16}) {
+    if (!runBenchmark(numWorkers, audio, numSessions)) {
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file test_lip_sync_ttff.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Time to first frame for whole-clip inputs of different lengths
+ * @version 0.1
+ * @date 2024-12-30
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "audio/audio_processor.hpp"
+#include "lip_sync/lip_sync_sdk.hpp"
+#include "logger/logger.hpp"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace lip_sync;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+// 整段提交一段音频，统计首帧与全部帧的耗时
+bool runBenchmark(LipSyncSDK &sdk, const std::vector<float> &audio,
+                  const std::string &uuid) {
+  auto start = std::chrono::steady_clock::now();
+  InputPacket input;
+  input.audioData = audio;
+  input.uuid = uuid;
+  if (sdk.startProcess(input) != ErrorCode::SUCCESS) {
+    LOGGER_ERROR("Failed to start process");
+    return false;
+  }
+
+  int64_t ttff = -1;
+  int numFrames = 0;
+  OutputPacket output;
+  while (true) {
+    if (sdk.tryGetNext(output) != ErrorCode::SUCCESS) {
+      continue;
+    }
+    if (ttff < 0) {
+      ttff = std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::steady_clock::now() - start)
+                 .count();
+    }
+    numFrames++;
+    if (output.isLastChunk) {
+      break;
+    }
+  }
+  auto total = std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+  std::cout << "Clip " << audio.size() / 16000 << " s: TTFF " << ttff
+            << " ms, " << numFrames << " frames in " << total << " ms"
+            << std::endl;
+  return true;
+}
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  audio::AudioProcessor audioProcessor;
+  auto audio = audioProcessor.readAudio("data/test.wav");
+  if (audio.empty()) {
+    LOGGER_ERROR("Failed to read audio");
+    return 1;
+  }
+
+  LipSyncSDK sdk;
+  SDKConfig config;
+  config.numWorkers = 2;
+  config.frameDir = "data/frames";
+  config.faceInfoPath = "data/face_bboxes.json";
+  config.encoderModelPath = "models/wenet_encoder.onnx";
+  config.wavLipModelPath = "models/w2l_with_wenet.onnx";
+  config.faceSize = 160;
+  config.facePad = 4;
+  config.maxCacheSize = 1024 * 1024 * 100;
+  config.frameRate = 20;
+  config.featureCacheSize = 1024 * 1024 * 256;
+
+  if (sdk.initialize(config) != ErrorCode::SUCCESS) {
+    LOGGER_ERROR("Failed to initialize SDK");
+    return 1;
+  }
+
+  // 重复拼接测试音频得到不同时长，TTFF 应与时长无关
+  std::vector<std::vector<float>> clips;
+  for (size_t seconds : {5, 20, 60}) {
+    std::vector<float> clip;
+    clip.reserve(seconds * 16000);
+    while (clip.size() < seconds * 16000) {
+      size_t size = std::min(audio.size(), seconds * 16000 - clip.size());
+      clip.insert(clip.end(), audio.begin(), audio.begin() + size);
+    }
+    if (!runBenchmark(sdk, clip, "ttff_" + std::to_string(seconds))) {
+      return 1;
+    }
+    clips.push_back(std::move(clip));
+  }
+
+  // 再次提交同样的音频，特征来自缓存，TTFF 约为首帧推理耗时
+  std::cout << "Replayed from the feature cache:" << std::endl;
+  for (size_t i = 0; i < clips.size(); ++i) {
+    if (!runBenchmark(sdk, clips[i], "ttff_cached_" + std::to_string(i))) {
+      return 1;
+    }
+  }
+
+  sdk.terminate();
+  return 0;
+}
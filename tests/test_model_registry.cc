@@ -0,0 +1,165 @@
+/**
+ * @file test_model_registry.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Inference objects sharing one session per model and settings
+ * @version 0.1
+ * @date 2025-01-10
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "core/model_registry.hpp"
+#include "core/types.hpp"
+#include "core/wavlip.hpp"
+#include "logger/logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <thread>
+#include <vector>
+
+using namespace lip_sync::infer;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  auto &registry = dnn::ModelRegistry::instance();
+  const int numWorkers = 4;
+
+  {
+    // The same file under two paths is loaded once
+    std::vector<std::unique_ptr<dnn::WavToLipInference>> models;
+    for (int i = 0; i < numWorkers; ++i) {
+      AlgoBase base;
+      base.name = "wavlip-" + std::to_string(i);
+      base.modelPath =
+          i % 2 ? "models/w2l_with_wenet.onnx" : "./models/w2l_with_wenet.onnx";
+      models.push_back(std::make_unique<dnn::WavToLipInference>(base));
+      if (!models.back()->initialize()) {
+        LOGGER_ERROR("Failed to initialize wav to lip model {}", i);
+        return 1;
+      }
+    }
+    if (registry.size() != 1) {
+      LOGGER_ERROR("Expected one shared session, got {}", registry.size());
+      return 1;
+    }
+
+    WeNetInput input;
+    int imageDims[] = {1, 6, 160, 160};
+    input.image = cv::Mat(4, imageDims, CV_32F);
+    input.audioFeature = cv::Mat(256, 512, CV_32F);
+    cv::randu(input.image, 0.0f, 1.0f);
+    cv::randu(input.audioFeature, -1.0f, 1.0f);
+    AlgoInput algoInput;
+    algoInput.setParams(input);
+
+    AlgoOutput reference;
+    reference.setParams(WeNetOutput{});
+    if (!models[0]->infer(algoInput, reference)) {
+      LOGGER_ERROR("Failed to run wav to lip inference");
+      return 1;
+    }
+
+    // Concurrent runs on the shared session, each with its own bindings
+    std::vector<AlgoOutput> outputs(numWorkers);
+    std::vector<int> succeeded(numWorkers, 0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numWorkers; ++i) {
+      outputs[i].setParams(WeNetOutput{});
+      threads.emplace_back([&, i]() {
+        AlgoInput threadInput = algoInput;
+        bool ok = true;
+        for (int run = 0; run < 8 && ok; ++run) {
+          ok = models[i]->infer(threadInput, outputs[i]);
+        }
+        succeeded[i] = ok;
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    const auto &expected = reference.getParams<WeNetOutput>()->mel;
+    for (int i = 0; i < numWorkers; ++i) {
+      const auto &mel = outputs[i].getParams<WeNetOutput>()->mel;
+      if (!succeeded[i] || mel != expected) {
+        LOGGER_ERROR("Concurrent run of model {} differs", i);
+        return 1;
+      }
+    }
+
+    // Another replica or other settings get a session of their own
+    AlgoBase replicaBase;
+    replicaBase.name = "wavlip-replica";
+    replicaBase.modelPath = "models/w2l_with_wenet.onnx";
+    replicaBase.replica = 1;
+    AlgoBase threadedBase = replicaBase;
+    threadedBase.name = "wavlip-threaded";
+    threadedBase.replica = 0;
+    threadedBase.session.intraOpThreads = 2;
+    dnn::WavToLipInference replica(replicaBase);
+    dnn::WavToLipInference threaded(threadedBase);
+    if (!replica.initialize() || !threaded.initialize()) {
+      LOGGER_ERROR("Failed to initialize wav to lip model sessions");
+      return 1;
+    }
+    if (registry.size() != 3) {
+      LOGGER_ERROR("Expected three sessions, got {}", registry.size());
+      return 1;
+    }
+    AlgoOutput threadedOutput;
+    threadedOutput.setParams(WeNetOutput{});
+    if (!threaded.infer(algoInput, threadedOutput)) {
+      LOGGER_ERROR("Failed to run the threaded session");
+      return 1;
+    }
+    const auto &threadedMel = threadedOutput.getParams<WeNetOutput>()->mel;
+    double maxDiff = 0.0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+      maxDiff = std::max<double>(maxDiff,
+                                 std::abs(threadedMel[i] - expected[i]));
+    }
+    if (threadedMel.size() != expected.size() || maxDiff > 1e-4) {
+      LOGGER_ERROR("Threaded session differs by {}", maxDiff);
+      return 1;
+    }
+  }
+
+  // Released with the last handle
+  if (registry.size() != 0) {
+    LOGGER_ERROR("Session still loaded after its models were released");
+    return 1;
+  }
+
+  {
+    // The Env was created without the global pool, a model asking for it
+    // falls back to a pool of its own, shared with the same settings
+    AlgoBase globalBase;
+    globalBase.name = "wavlip-global";
+    globalBase.modelPath = "models/w2l_with_wenet.onnx";
+    globalBase.session.globalThreadPool = true;
+    AlgoBase ownBase = globalBase;
+    ownBase.name = "wavlip-own";
+    ownBase.session.globalThreadPool = false;
+    dnn::WavToLipInference global(globalBase);
+    dnn::WavToLipInference own(ownBase);
+    if (!global.initialize() || !own.initialize()) {
+      LOGGER_ERROR("Model asking for the missing global pool did not load");
+      return 1;
+    }
+    if (registry.size() != 1) {
+      LOGGER_ERROR("Expected one fallback session, got {}", registry.size());
+      return 1;
+    }
+  }
+
+  std::cout << numWorkers << " models shared one session" << std::endl;
+  return 0;
+}
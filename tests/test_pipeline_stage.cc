@@ -0,0 +1,118 @@
+/**
+ * @file test_pipeline_stage.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief DROP_OLDEST keeps stage queues within their capacity
+ * @version 0.1
+ * @date 2025-01-10
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "lip_sync/pipeline_stage.hpp"
+#include "logger/logger.hpp"
+#include "utils/thread_safe_queue.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace lip_sync;
+using utils::DropPushResult;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  // 负数不可丢弃，模拟结束帧
+  auto canDrop = [](const int &item) { return item >= 0; };
+
+  utils::ThreadSafeQueue<int> queue(2);
+  int value = 1;
+  queue.push_drop_oldest(value, canDrop);
+  value = 2;
+  queue.push_drop_oldest(value, canDrop);
+  value = 3;
+  if (queue.push_drop_oldest(value, canDrop) !=
+          DropPushResult::DROPPED_OLDEST ||
+      queue.size() != 2 || queue.try_pop() != 2) {
+    LOGGER_ERROR("Oldest droppable item was not replaced");
+    return 1;
+  }
+  queue.clear();
+  value = -1;
+  queue.push_drop_oldest(value, canDrop);
+  value = -2;
+  queue.push_drop_oldest(value, canDrop);
+  value = 4;
+  if (queue.push_drop_oldest(value, canDrop) != DropPushResult::FULL ||
+      queue.size() != 2 || value != 4) {
+    LOGGER_ERROR("Queue without droppable items grew past its capacity");
+    return 1;
+  }
+
+  // 处理线程卡住，队列被不可丢弃的数据占满后继续推入
+  const size_t capacity = 4;
+  PipelineStage<int> stage("drop", capacity, OverflowPolicy::DROP_OLDEST,
+                           canDrop);
+  std::atomic<bool> busy{false};
+  std::atomic<bool> release{false};
+  std::vector<int> handled;
+  stage.start(1, [&](std::vector<int> &items, size_t) {
+    busy = true;
+    while (!release) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    handled.insert(handled.end(), items.begin(), items.end());
+  });
+  stage.push(0);
+  while (!busy) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  for (int i = 1; i <= static_cast<int>(capacity); ++i) {
+    stage.push(-i);
+  }
+
+  // 可丢弃的新数据被丢弃，队列不超出容量
+  const int numPushed = 100;
+  for (int i = 1; i <= numPushed; ++i) {
+    if (!stage.push(i)) {
+      LOGGER_ERROR("Push {} failed", i);
+      return 1;
+    }
+  }
+  auto stats = stage.getStats();
+  std::cout << "Queue depth " << stats.queueDepth << ", dropped "
+            << stats.dropped << std::endl;
+  if (stats.queueDepth != capacity || stats.dropped != numPushed) {
+    LOGGER_ERROR("Stage queue grew past its capacity");
+    return 1;
+  }
+
+  // 不可丢弃的新数据等待空位，处理恢复后仍按序处理
+  std::thread pusher([&]() { stage.push(-100); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  if (stage.getStats().queueDepth != capacity) {
+    LOGGER_ERROR("Undroppable item was pushed into a full queue");
+    release = true;
+    pusher.join();
+    return 1;
+  }
+  release = true;
+  pusher.join();
+  while (stage.getStats().processed < capacity + 2) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  stage.stop();
+
+  const std::vector<int> expected = {0, -1, -2, -3, -4, -100};
+  if (handled != expected) {
+    LOGGER_ERROR("Undroppable items were lost or reordered");
+    return 1;
+  }
+  return 0;
+}
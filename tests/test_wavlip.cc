@@ -208,7 +208,11 @@ int main(int argc, char **argv) {
   printFeatureStats(wenetFeatures);
 
   auto audioChunks = featureExtractor.convertToChunks(wenetFeatures);
-  printFeatureStats(audioChunks);
+  std::vector<cv::Mat> chunkMats;
+  for (const auto &chunk : audioChunks) {
+    chunkMats.push_back(chunk.toMat());
+  }
+  printFeatureStats(chunkMats);
 
   // Initialize wav to lip engine
   AlgoBase wavToLipAlgoBase;
@@ -238,7 +242,7 @@ int main(int argc, char **argv) {
 
   WeNetInput wavToLipInput;
   wavToLipInput.image = processed.xData;
-  wavToLipInput.audioFeature = audioChunks[0];
+  wavToLipInput.audioFeature = chunkMats[0];
 
   AlgoInput wavToLipInputParam;
   wavToLipInputParam.setParams(wavToLipInput);
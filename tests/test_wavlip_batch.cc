@@ -0,0 +1,87 @@
+/**
+ * @file test_wavlip_batch.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Wav to lip throughput with packed batches
+ * @version 0.1
+ * @date 2024-12-23
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "core/types.hpp"
+#include "core/wavlip.hpp"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+
+#include "logger/logger.hpp"
+
+namespace fs = std::filesystem;
+using namespace lip_sync::infer;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+// 以随机输入测量给定批大小下的帧吞吐
+double benchmarkBatch(dnn::WavToLipInference &wavToLip, int batchSize,
+                      int numFrames) {
+  int imageDims[] = {batchSize, 6, 160, 160};
+  WeNetInput input;
+  input.image = cv::Mat(4, imageDims, CV_32F);
+  input.audioFeature = cv::Mat(batchSize * 256, 512, CV_32F);
+  cv::randu(input.image, 0.0f, 1.0f);
+  cv::randu(input.audioFeature, -1.0f, 1.0f);
+
+  AlgoInput algoInput;
+  algoInput.setParams(input);
+
+  // 预热
+  AlgoOutput algoOutput;
+  algoOutput.setParams(WeNetOutput{});
+  if (!wavToLip.infer(algoInput, algoOutput)) {
+    return 0.0;
+  }
+
+  const int numRuns = std::max(numFrames / batchSize, 1);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < numRuns; ++i) {
+    algoOutput.setParams(WeNetOutput{});
+    if (!wavToLip.infer(algoInput, algoOutput)) {
+      return 0.0;
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return numRuns * batchSize / elapsed.count();
+}
+
+int main(int argc, char **argv) {
+  fs::path modelDir = fs::path("models");
+
+  AlgoBase wavToLipAlgoBase;
+  wavToLipAlgoBase.name = "wavlip";
+  wavToLipAlgoBase.modelPath = (modelDir / "w2l_with_wenet.onnx").string();
+
+  dnn::WavToLipInference wavToLip(wavToLipAlgoBase);
+  if (!wavToLip.initialize()) {
+    LOGGER_ERROR("Failed to initialize wav to lip model");
+    return 1;
+  }
+
+  if (!wavToLip.supportsBatch()) {
+    LOGGER_ERROR("Wav to lip model has a fixed batch size, export it with a "
+                 "dynamic batch dimension to benchmark batching");
+    return 1;
+  }
+
+  const int numFrames = 256;
+  for (int batchSize : {1, 2, 4, 8, 16}) {
+    double fps = benchmarkBatch(wavToLip, batchSize, numFrames);
+    std::cout << "Batch " << batchSize << ": " << fps << " frames/s"
+              << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file test_wenet_batch.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Encoder windows per second against batch size
+ * @version 0.1
+ * @date 2024-12-31
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "audio/audio_processor.hpp"
+#include "core/feature_extractor.hpp"
+#include "core/types.hpp"
+#include "logger/logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace lip_sync::audio;
+using namespace lip_sync::infer;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  AudioProcessor audioProcessor;
+  auto audio = audioProcessor.readAudio("data/test.wav");
+  if (audio.empty()) {
+    LOGGER_ERROR("Failed to read audio");
+    return 1;
+  }
+
+  // Encoder windows of the clip, as extractWenetFeatures builds them
+  WeNetConfig wenetConfig;
+  wenetConfig.modelPath = "models/wenet_encoder.onnx";
+  FeatureExtractor fbankExtractor;
+  auto fbank = fbankExtractor.computeFbank(audioProcessor.preprocess(audio));
+  const int numFrames = fbank.size();
+  std::vector<cv::Mat> windows;
+  for (int start = 0, end = 0; end < numFrames;
+       start += wenetConfig.slidingStep) {
+    end = start + wenetConfig.framesStride;
+    cv::Mat window(wenetConfig.framesStride * wenetConfig.numFeatures, 1,
+                   CV_32F, cv::Scalar(0));
+    for (int i = start; i < std::min(end, numFrames); ++i) {
+      std::memcpy(window.ptr<float>() + (i - start) * wenetConfig.numFeatures,
+                  fbank[i].data(), wenetConfig.numFeatures * sizeof(float));
+    }
+    windows.push_back(window);
+  }
+
+  std::vector<cv::Mat> reference;
+  for (int batchSize : {1, 2, 4, 8, 16, 32}) {
+    wenetConfig.batchSize = batchSize;
+    FeatureExtractor extractor(FbankConfig{}, wenetConfig);
+    if (!extractor.initialize()) {
+      LOGGER_ERROR("Failed to initialize feature extractor");
+      return 1;
+    }
+
+    // Warm up outside of the measurement
+    const size_t numWarmup = std::min<size_t>(batchSize, windows.size());
+    extractor.encodeWindows({windows.begin(), windows.begin() + numWarmup});
+
+    auto start = std::chrono::steady_clock::now();
+    auto features = extractor.encodeWindows(windows);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << "Batch " << batchSize << ": "
+              << windows.size() / elapsed.count() << " windows/s" << std::endl;
+
+    // Batched windows must encode the same as single ones
+    if (reference.empty()) {
+      reference = features;
+      continue;
+    }
+    for (size_t i = 0; i < features.size(); ++i) {
+      if (cv::norm(features[i], reference[i], cv::NORM_INF) > 1e-3) {
+        LOGGER_ERROR("Batch {} differs at window {}", batchSize, i);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,167 @@
+/**
+ * @file test_wenet_incremental.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Parity and cost of the incremental encoder against windowed encoding
+ * @version 0.1
+ * @date 2024-12-31
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "audio/audio_processor.hpp"
+#include "core/face_processor.hpp"
+#include "core/feature_extractor.hpp"
+#include "core/types.hpp"
+#include "core/wavlip.hpp"
+#include "logger/logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <opencv2/imgcodecs.hpp>
+#include <vector>
+
+using namespace lip_sync::audio;
+using namespace lip_sync::infer;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+double meanSquaredError(const cv::Mat &a, const cv::Mat &b) {
+  cv::Mat diff;
+  cv::subtract(a, b, diff);
+  return cv::mean(diff.mul(diff))[0];
+}
+
+// Encode the clip and report the elapsed time
+bool encode(const std::vector<std::vector<float>> &fbank, bool incremental,
+            std::vector<cv::Mat> &features) {
+  WeNetConfig wenetConfig;
+  wenetConfig.modelPath = "models/wenet_encoder.onnx";
+  wenetConfig.incremental = incremental;
+  FeatureExtractor extractor(FbankConfig{}, wenetConfig);
+  if (!extractor.initialize()) {
+    LOGGER_ERROR("Failed to initialize feature extractor");
+    return false;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  features = extractor.extractWenetFeatures(fbank);
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::cout << (incremental ? "Incremental" : "Windowed") << " encoder: "
+            << features.size() << " features in " << elapsed << " ms"
+            << std::endl;
+  return true;
+}
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  AudioProcessor audioProcessor;
+  auto audio = audioProcessor.readAudio("data/test.wav");
+  if (audio.empty()) {
+    LOGGER_ERROR("Failed to read audio");
+    return 1;
+  }
+
+  FeatureExtractor fbankExtractor;
+  auto fbank = fbankExtractor.computeFbank(audioProcessor.preprocess(audio));
+
+  std::vector<cv::Mat> windowed;
+  std::vector<cv::Mat> incremental;
+  if (!encode(fbank, false, windowed) || !encode(fbank, true, incremental)) {
+    return 1;
+  }
+  if (windowed.size() != incremental.size()) {
+    LOGGER_ERROR("Feature count differs: {} vs {}", windowed.size(),
+                 incremental.size());
+    return 1;
+  }
+
+  // The first window sees the same zeroed caches in both modes
+  if (meanSquaredError(windowed[0], incremental[0]) > 1e-10) {
+    LOGGER_ERROR("First feature differs");
+    return 1;
+  }
+
+  // Encoder feature error, relative to the feature energy
+  double sumError = 0.0;
+  double maxError = 0.0;
+  double sumEnergy = 0.0;
+  for (size_t i = 0; i < windowed.size(); ++i) {
+    double error = meanSquaredError(windowed[i], incremental[i]);
+    sumError += error;
+    maxError = std::max(maxError, error);
+    sumEnergy += cv::mean(windowed[i].mul(windowed[i]))[0];
+  }
+  std::cout << "Feature MSE: mean " << sumError / windowed.size() << ", max "
+            << maxError << ", relative " << sumError / sumEnergy << std::endl;
+
+  // Lip output difference on the frames the model actually sees
+  auto windowedChunks = fbankExtractor.convertToChunks(windowed);
+  auto incrementalChunks = fbankExtractor.convertToChunks(incremental);
+
+  AlgoBase wavToLipAlgoBase;
+  wavToLipAlgoBase.name = "wavlip";
+  wavToLipAlgoBase.modelPath = "models/w2l_with_wenet.onnx";
+  dnn::WavToLipInference wavToLip(wavToLipAlgoBase);
+  if (!wavToLip.initialize()) {
+    LOGGER_ERROR("Failed to initialize wav to lip model");
+    return 1;
+  }
+
+  cv::Mat frame = cv::imread("data/image.jpg");
+  if (frame.empty()) {
+    LOGGER_ERROR("Failed to load image");
+    return 1;
+  }
+  FaceProcessor processor(160, 4);
+  ProcessedFaceData processed =
+      processor.preProcess(frame, cv::Rect(476, 832, 645 - 476, 1001 - 832));
+
+  auto inferMel = [&](const AudioChunk &chunk, std::vector<float> &mel) {
+    WeNetInput wavToLipInput;
+    wavToLipInput.image = processed.xData;
+    wavToLipInput.audioFeature = chunk.toMat();
+    AlgoInput input;
+    input.setParams(wavToLipInput);
+    AlgoOutput output;
+    output.setParams(WeNetOutput{});
+    if (!wavToLip.infer(input, output)) {
+      return false;
+    }
+    mel = std::move(output.getParams<WeNetOutput>()->mel);
+    return true;
+  };
+
+  const size_t step = std::max<size_t>(windowedChunks.size() / 50, 1);
+  double sumDiff = 0.0;
+  double maxDiff = 0.0;
+  size_t numFrames = 0;
+  for (size_t i = 0; i < windowedChunks.size(); i += step) {
+    std::vector<float> windowedMel;
+    std::vector<float> incrementalMel;
+    if (!inferMel(windowedChunks[i], windowedMel) ||
+        !inferMel(incrementalChunks[i], incrementalMel)) {
+      LOGGER_ERROR("Failed to run wav to lip inference");
+      return 1;
+    }
+
+    // Mean absolute difference of the generated face in 8-bit pixel units
+    double diff = 0.0;
+    for (size_t j = 0; j < windowedMel.size(); ++j) {
+      diff += std::abs(windowedMel[j] - incrementalMel[j]);
+    }
+    diff = diff / windowedMel.size() * 255.0;
+    sumDiff += diff;
+    maxDiff = std::max(maxDiff, diff);
+    numFrames++;
+  }
+  std::cout << "Lip output difference over " << numFrames
+            << " frames (0-255): mean " << sumDiff / numFrames << ", max "
+            << maxDiff << std::endl;
+  return 0;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file test_wenet_silence.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Cached encoder features of silent windows against encoding them
+ * @version 0.1
+ * @date 2025-01-07
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "audio/audio_processor.hpp"
+#include "core/feature_extractor.hpp"
+#include "core/types.hpp"
+#include "logger/logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace lip_sync::audio;
+using namespace lip_sync::infer;
+
+const auto initLogger = []() -> decltype(auto) {
+  LipSyncLoggerInit(true, true, true, true);
+  return true;
+}();
+
+int main(int argc, char **argv) {
+  LipSyncLoggerSetLevel(2);
+
+  AudioProcessor audioProcessor;
+  auto audio = audioProcessor.readAudio("data/test.wav");
+  if (audio.empty()) {
+    LOGGER_ERROR("Failed to read audio");
+    return 1;
+  }
+
+  // Speech with pauses: the clip three times with a second of silence and
+  // a second of constant offset between the copies
+  std::vector<float> paused;
+  for (int i = 0; i < 3; ++i) {
+    paused.insert(paused.end(), audio.begin(), audio.end());
+    paused.insert(paused.end(), 16000, 0.0f);
+    paused.insert(paused.end(), 16000, 0.01f);
+  }
+  auto samples = audioProcessor.preprocess(paused);
+
+  std::vector<cv::Mat> reference;
+  double referenceSeconds = 0.0;
+  for (bool silenceCache : {false, true}) {
+    WeNetConfig wenetConfig;
+    wenetConfig.modelPath = "models/wenet_encoder.onnx";
+    wenetConfig.silenceCache = silenceCache;
+    FeatureExtractor extractor(FbankConfig{}, wenetConfig);
+    if (!extractor.initialize()) {
+      LOGGER_ERROR("Failed to initialize feature extractor");
+      return 1;
+    }
+
+    auto fbank = extractor.computeFbank(samples);
+    auto start = std::chrono::steady_clock::now();
+    auto features = extractor.extractWenetFeatures(fbank);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    if (!silenceCache) {
+      reference = features;
+      referenceSeconds = elapsed.count();
+      continue;
+    }
+    if (features.size() != reference.size()) {
+      LOGGER_ERROR("Feature count differs: {} vs {}", features.size(),
+                   reference.size());
+      return 1;
+    }
+
+    // Cached windows share one Mat, the others are encoded on their own
+    std::map<const uchar *, size_t> numShared;
+    size_t numCached = 0;
+    for (size_t i = 0; i < features.size(); ++i) {
+      if (cv::norm(features[i], reference[i], cv::NORM_INF) > 1e-3) {
+        LOGGER_ERROR("Silence cache differs at window {}", i);
+        return 1;
+      }
+      numCached = std::max(numCached, ++numShared[features[i].data]);
+    }
+    std::cout << numCached << " of " << features.size()
+              << " windows from the silence cache, " << referenceSeconds
+              << " s without, " << elapsed.count() << " s with the cache"
+              << std::endl;
+    if (numCached < 2) {
+      LOGGER_ERROR("Silent windows were not taken from the cache");
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file lip_sync_precompute.cc
+ * @author Sinter Wong (sintercver@gmail.com)
+ * @brief Precompute the audio features of clips into feature files
+ * @version 0.1
+ * @date 2025-01-09
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "feature_precompute.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace lip_sync;
+
+void printUsage(const char *name) {
+  std::cerr << "Usage: " << name
+            << " --encoder <model.onnx> [--batch <size>] [--threads <n>]"
+               " [--incremental] <audio.wav> <output.feat>"
+               " [<audio.wav> <output.feat> ...]"
+            << std::endl;
+}
+
+int main(int argc, char **argv) {
+  PrecomputeConfig config;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--encoder") && i + 1 < argc) {
+      config.encoderModelPath = argv[++i];
+    } else if (!std::strcmp(argv[i], "--batch") && i + 1 < argc) {
+      config.encoderBatchSize = std::atoi(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) {
+      config.encoderSession.intraOpThreads = std::atoi(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--incremental")) {
+      config.incrementalEncoder = true;
+    } else if (argv[i][0] == '-') {
+      printUsage(argv[0]);
+      return 1;
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+  if (config.encoderModelPath.empty() || paths.empty() ||
+      paths.size() % 2 != 0) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  FeaturePrecompute precompute;
+  if (precompute.initialize(config) != ErrorCode::SUCCESS) {
+    std::cerr << "Failed to load " << config.encoderModelPath << std::endl;
+    return 1;
+  }
+
+  // Pairs of input audio and output feature file
+  int numFailed = 0;
+  for (size_t i = 0; i < paths.size(); i += 2) {
+    InputPacket input;
+    input.audioPath = paths[i];
+    input.uuid = paths[i];
+    auto start = std::chrono::steady_clock::now();
+    auto ret = precompute.process(input, paths[i + 1]);
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (ret != ErrorCode::SUCCESS) {
+      std::cerr << paths[i] << ": failed with error "
+                << static_cast<int>(ret) << std::endl;
+      numFailed++;
+      continue;
+    }
+    std::cout << paths[i] << " -> " << paths[i + 1] << " in "
+              << elapsed.count() << " ms" << std::endl;
+  }
+  return numFailed == 0 ? 0 : 1;
+}